@@ -0,0 +1,128 @@
+#!/bin/sh
+#
+# End-to-end fill benchmark.
+#
+#   bench/bench.sh [-b] [-r] [-n runs] [-t percent] [-w wordlist] [fill]
+#
+# Runs each case in bench/cases n times (default 3), with seeds 1..n, and
+# reports the median wall time and node count, the peak RSS, how many runs
+# gave the expected outcome and the mean fill quality (the mean dictionary
+# score of the words in the fill, as --stats reports it).  The results are
+# compared with bench/baseline: a case regresses if its time, nodes or
+# memory grow, or its quality falls, by more than the threshold (default
+# 10%), or if any run gives the wrong outcome.  -b writes the results to
+# bench/baseline instead, and -r prints them without comparing.  -w adds
+# cases filling am15, am21 and brit15 from a real word list in load_dict()
+# format.
+
+dir=$(cd "$(dirname "$0")" && pwd)
+runs=3
+thr=10
+mkbase=0
+raw=0
+words=
+while getopts brn:t:w: o; do
+	case $o in
+	b) mkbase=1 ;;
+	r) raw=1 ;;
+	n) runs=$OPTARG ;;
+	t) thr=$OPTARG ;;
+	w) words=$OPTARG ;;
+	*) echo "usage: $0 [-b] [-r] [-n runs] [-t percent] [-w wordlist] [fill]" >&2; exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+fill=${1:-$dir/../fill}
+tmp=$(mktemp -d) || exit 2
+trap 'rm -rf "$tmp"' EXIT
+
+# value of key $2 in the flat JSON record in file $1
+jget() {
+	sed -n "s/.*\"$2\": \([^,}]*\).*/\1/p" "$1"
+}
+
+# runcase name grid dictionary expect [options]: one line of results
+runcase() {
+	name=$1 grid=$2 dict=$3 expect=$4
+	shift 4
+	: > "$tmp/runs"
+	s=1
+	while [ $s -le $runs ]; do
+		rm -f "$tmp/s.json"
+		t0=$(date +%s%N)
+		"$fill" --seed $s --stats="$tmp/s.json" -d "$dict" "$@" < "$dir/grids/$grid.txt" > /dev/null 2>&1
+		t1=$(date +%s%N)
+		if [ -s "$tmp/s.json" ]; then
+			echo "$(( (t1 - t0) / 1000000 )) $(jget "$tmp/s.json" nodes) $(jget "$tmp/s.json" maxrss_kb)" \
+				"$(jget "$tmp/s.json" status) $(jget "$tmp/s.json" quality)" >> "$tmp/runs"
+		else
+			echo "$(( (t1 - t0) / 1000000 )) 0 0 crash null" >> "$tmp/runs"
+		fi
+		s=$((s + 1))
+	done
+	sort -n "$tmp/runs" | awk -v name="$name" -v expect="$expect" '
+		{
+			t[NR] = $1; n[NR] = $2
+			if ($3 > rss) rss = $3
+			if ((expect == "fill" && $4 == 2) || (expect == "nofill" && $4 == 1) || (expect == "any" && ($4 == 1 || $4 == 2)))
+				ok++
+			if ($5 != "null") { q += $5; nq++ }
+		}
+		END {
+			m = int((NR + 1) / 2)
+			for (i = 2; i <= NR; i++)
+				for (j = i; j > 1 && n[j - 1] > n[j]; j--) {
+					x = n[j]; n[j] = n[j - 1]; n[j - 1] = x
+				}
+			printf "%-12s %8d %10d %8d %3d/%-3d %s\n", name, t[m], n[m], rss, ok, NR, nq ? sprintf("%.4f", q / nq) : "-"
+		}'
+}
+
+{
+	grep -v '^#' "$dir/cases" | while read -r name grid dict expect opts; do
+		[ -n "$name" ] && runcase "$name" "$grid" "$dir/dicts/$dict.dict" "$expect" $opts
+	done
+	if [ -n "$words" ]; then
+		for grid in am15 am21 brit15; do
+			runcase "$grid-words" "$grid" "$words" any --timeout 60
+		done
+	fi
+} > "$tmp/results"
+
+if [ $mkbase = 1 ]; then
+	{
+		echo "# case        time_ms      nodes   rss_kb  ok/runs quality"
+		cat "$tmp/results"
+	} > "$dir/baseline"
+	cat "$dir/baseline"
+	exit 0
+fi
+if [ $raw = 1 ]; then
+	cat "$tmp/results"
+	exit 0
+fi
+
+base=$dir/baseline
+[ -f "$base" ] || base=/dev/null
+awk -v thr="$thr" '
+	function pct(a, b) { return b ? sprintf("%+.1f%%", 100 * (a - b) / b) : "-" }
+	FILENAME == ARGV[1] { if ($1 !~ /^#/) { bt[$1] = $2; bn[$1] = $3; br[$1] = $4; bq[$1] = $6 } next }
+	FNR == 1 { printf "%-12s %8s %8s %10s %8s %8s %8s %7s %8s\n", "case", "time_ms", "", "nodes", "", "rss_kb", "", "ok", "quality" }
+	{
+		bad = ""
+		split($5, ok, "/")
+		if (ok[1] != ok[2]) bad = bad " outcome"
+		if ($1 in bt) {
+			f = 1 + thr / 100
+			if ($2 > bt[$1] * f && $2 - bt[$1] > 5) bad = bad " time"
+			if ($3 > bn[$1] * f) bad = bad " nodes"
+			if ($4 > br[$1] * f) bad = bad " memory"
+			if ($6 != "-" && bq[$1] != "-" && $6 < bq[$1] - (bq[$1] < 0 ? -bq[$1] : bq[$1]) * thr / 100) bad = bad " quality"
+		}
+		printf "%-12s %8d %8s %10d %8s %8d %8s %7s %8s%s\n", $1,
+			$2, pct($2, bt[$1]), $3, pct($3, bn[$1]), $4, pct($4, br[$1]), $5, $6,
+			bad == "" ? "" : "  REGRESSED:" bad
+		if (bad != "") nbad++
+	}
+	END { if (nbad) { printf "%d case(s) regressed beyond %s%%\n", nbad, thr; exit 1 } }
+' "$base" "$tmp/results"
@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# Answer checks for fill.
+#
+#   bench/check.sh [fill]
+#
+# Runs each case in bench/checks once, with seed 1, and checks that it
+# gives the expected outcome, and that a fill keeps the grid's preset
+# letters and uses only dictionary words, none of them twice.  The cases
+# run the same grid and dictionary under different search options, so
+# that an option which loses fills, or finds bad ones, shows up here
+# rather than as an odd node count in bench.sh.  Prints one line per case
+# and exits non-zero if any of them fails.
+
+dir=$(cd "$(dirname "$0")" && pwd)
+fill=${1:-$dir/../fill}
+tmp=$(mktemp -d) || exit 2
+trap 'rm -rf "$tmp"' EXIT
+
+# value of key $2 in the flat JSON record in file $1
+jget() {
+	sed -n "s/.*\"$2\": \([^,}]*\).*/\1/p" "$1"
+}
+
+# checkfill grid dictionary output: "ok", or what is wrong with the fill
+checkfill() {
+	awk '
+		FILENAME == ARGV[1] { dict[toupper($1)] = 1; next }
+		FILENAME == ARGV[2] { if (NF) g[++h] = $0; next }
+		NF { o[++n] = $0 }
+		END {
+			w = length(g[1])
+			for (y = 1; y <= h; y++) {
+				r[y] = o[n - h + y]
+				if (length(r[y]) != w) { print "bad grid"; exit }
+				for (x = 1; x <= w; x++) {
+					c = substr(g[y], x, 1)
+					if (c != "." && c != substr(r[y], x, 1)) { print "preset changed at " x "," y; exit }
+				}
+			}
+			# every across and down light of two or more cells
+			for (y = 1; y <= h; y++) ls[++nl] = r[y]
+			for (x = 1; x <= w; x++) {
+				s = ""
+				for (y = 1; y <= h; y++) s = s substr(r[y], x, 1)
+				ls[++nl] = s
+			}
+			for (i = 1; i <= nl; i++) {
+				m = split(ls[i], p, "#")
+				for (j = 1; j <= m; j++) {
+					if (length(p[j]) < 2) continue
+					if (!(p[j] in dict)) { print "not a word: " p[j]; exit }
+					if (p[j] in used) { print "used twice: " p[j]; exit }
+					used[p[j]] = 1
+				}
+			}
+			print "ok"
+		}' "$1" "$2" "$3"
+}
+
+nbad=0
+while read -r name grid dict expect opts; do
+	case $name in ''|'#'*) continue ;; esac
+	rm -f "$tmp/s.json"
+	"$fill" --seed 1 --stats="$tmp/s.json" -d "$dir/dicts/$dict.dict" $opts < "$dir/grids/$grid.txt" > "$tmp/out" 2> /dev/null
+	st=$(jget "$tmp/s.json" status)
+	case $st in
+	2) got=fill ;;
+	1) got=nofill ;;
+	'') got=crash ;;
+	*) got="status $st" ;;
+	esac
+	why=
+	if [ "$got" != "$expect" ]; then
+		why="got $got"
+	elif [ $got = fill ]; then
+		v=$(checkfill "$dir/dicts/$dict.dict" "$dir/grids/$grid.txt" "$tmp/out")
+		[ "$v" = ok ] || why=$v
+	fi
+	if [ -n "$why" ]; then
+		printf "%-20s %-7s %-20s FAILED: %s\n" "$name" "$expect" "$opts" "$why"
+		nbad=$((nbad + 1))
+	else
+		printf "%-20s %-7s %-20s ok\n" "$name" "$expect" "$opts"
+	fi
+done < "$dir/checks"
+[ $nbad = 0 ] || { echo "$nbad check(s) failed"; exit 1; }
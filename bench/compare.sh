@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# Compare builds of fill on the benchmark corpus.
+#
+#   bench/compare.sh [-n runs] [-w wordlist] fill other...
+#
+# Runs bench.sh -r on each binary in turn and prints the median time of
+# every case for each, with its change against the first binary (the
+# plain build), then the geometric mean of those changes and each
+# binary's size.  The builds should search identically, so a case whose
+# node count differs from the first binary's is flagged.
+
+dir=$(cd "$(dirname "$0")" && pwd)
+flags=
+while getopts n:w: o; do
+	case $o in
+	n) flags="$flags -n $OPTARG" ;;
+	w) flags="$flags -w $OPTARG" ;;
+	*) echo "usage: $0 [-n runs] [-w wordlist] fill other..." >&2; exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+[ $# -ge 2 ] || { echo "usage: $0 [-n runs] [-w wordlist] fill other..." >&2; exit 2; }
+tmp=$(mktemp -d) || exit 2
+trap 'rm -rf "$tmp"' EXIT
+
+i=0
+for f in "$@"; do
+	i=$((i + 1))
+	sh "$dir/bench.sh" -r $flags "$f" > "$tmp/r$i" || exit 1
+	echo "$f $(wc -c < "$f")" >> "$tmp/bins"
+done
+
+awk -v nb=$# '
+	# binaries first, then each result file in the same order
+	FILENAME == ARGV[1] { name[++b] = $1; size[b] = $2; next }
+	FNR == 1 { k++ }
+	{
+		if (k == 1) { order[++nc] = $1; n0[$1] = $3 }
+		t[$1, k] = $2
+		if ($3 != n0[$1]) diff[$1] = 1
+	}
+	END {
+		printf "%-12s", "case"
+		for (b = 1; b <= nb; b++) printf " %14s%s", name[b], (b > 1 ? "        " : "")
+		printf "\n"
+		for (c = 1; c <= nc; c++) {
+			x = order[c]
+			printf "%-12s %14d", x, t[x, 1]
+			for (b = 2; b <= nb; b++) {
+				printf " %14d %+6.1f%%", t[x, b], t[x, 1] ? 100 * (t[x, b] - t[x, 1]) / t[x, 1] : 0
+				if (t[x, 1] > 0 && t[x, b] > 0) { lg[b] += log(t[x, b] / t[x, 1]); ng[b]++ }
+			}
+			printf "%s\n", diff[x] ? "  (node counts differ)" : ""
+		}
+		printf "%-12s %14s", "geomean", ""
+		for (b = 2; b <= nb; b++) printf " %14s %+6.1f%%", "", ng[b] ? 100 * (exp(lg[b] / ng[b]) - 1) : 0
+		printf "\n%-12s", "size"
+		for (b = 1; b <= nb; b++) printf " %14d%s", size[b], (b > 1 ? "        " : "")
+		printf "\n"
+	}' "$tmp/bins" $(i=1; while [ $i -le $# ]; do echo "$tmp/r$i"; i=$((i + 1)); done)
@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# Start-up cost of fill.
+#
+#   bench/startup.sh [-n runs] [fill...]
+#
+# Runs each given fill binary (default ./fill) n times (default 500) on a
+# one-light grid with a one-word dictionary, so that the time is almost
+# all process start-up, dynamic linking and relocation, and prints the
+# mean wall time per run.  /bin/true is timed the same way as a floor.
+
+dir=$(cd "$(dirname "$0")" && pwd)
+runs=500
+while getopts n: o; do
+	case $o in
+	n) runs=$OPTARG ;;
+	*) echo "usage: $0 [-n runs] [fill...]" >&2; exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+[ $# -gt 0 ] || set -- "$dir/../fill"
+tmp=$(mktemp -d) || exit 2
+trap 'rm -rf "$tmp"' EXIT
+echo "ABC 1" > "$tmp/dict"
+echo "..." > "$tmp/grid"
+
+# timeit name command...: mean microseconds per run
+timeit() {
+	name=$1
+	shift
+	"$@" < "$tmp/grid" > /dev/null 2>&1 || { printf "%-24s failed\n" "$name"; return; }
+	i=0
+	t0=$(date +%s%N)
+	while [ $i -lt $runs ]; do
+		"$@" < "$tmp/grid" > /dev/null 2>&1
+		i=$((i + 1))
+	done
+	t1=$(date +%s%N)
+	printf "%-24s %8d us/run\n" "$name" $(( (t1 - t0) / 1000 / runs ))
+}
+
+timeit /bin/true /bin/true
+for f in "$@"; do
+	timeit "$f" "$f" -d "$tmp/dict"
+done
@@ -35,6 +35,7 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 #include <assert.h>
 #include <ctype.h>
 #include <time.h>
+#include <signal.h>
 
 #define DIR_SEP_STR "/"
 #define DIR_SEP_CHAR '/'
@@ -108,6 +109,12 @@ struct sprop { // square properties
 
 // entry methods
 #define EM_FWD 1
+#define EM_REV 2
+#define EM_CYC 4
+#define EM_RCY 8
+#define EM_JUM 16
+#define EM_ALL 31
+#define EM_SPR 32      // "spread" message entry: internal use only
 
 struct lprop { // light properties
   unsigned int dmask; // mask of allowed dictionaries; special values 1<<MAXNDICTS and above for "implicit" words
@@ -191,6 +198,7 @@ extern struct vl vls[NVL];
 extern int nc,nw,ntw,ne,ne0,ns,nvl;
 
 extern int cwperm[NL-1]; // "codeword" permutation
+extern struct rng crng;  // for cwperm
 
 // DICTIONARY
 
@@ -230,7 +238,7 @@ extern int llistwlen;           // word length applicable to matching lights
 extern unsigned int llistdm;    // dictionary mask applicable to matching lights
 extern int llistem;             // entry method mask applicable to matching lights
 
-extern volatile int abort_flag; // abort word list building?
+extern volatile sig_atomic_t abort_flag; // cancel the fill: set by SIGINT or SIGTERM, polled by list building and the search
 
 extern struct answer**ansp;
 extern struct light*lts;
@@ -278,6 +286,8 @@ extern int prefdata[NPREFS];
 
 void update_grid(void);
 void mkfeas(void);
+void report_fill(int n);
+void report_progress(const ABM*fl,int dep,unsigned long long nodes,double rate);
 char abmtoechar(ABM b);
 void reperr(const char *s);
 
@@ -291,4 +301,50 @@ static inline int onebit(int x)
 	return x != 0 && (x & (x-1)) == 0;
 }
 
+// xoshiro256** pseudo-random generator; each user keeps its own state, so a seed gives
+// the same sequence whatever else draws numbers
+struct rng {
+	unsigned long long s[4];
+};
+
+static inline unsigned long long rng_rotl(unsigned long long x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline unsigned long long rng_next(struct rng *g)
+{
+	unsigned long long *s = g->s;
+	unsigned long long r = rng_rotl(s[1] * 5, 7) * 9;
+	unsigned long long t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rng_rotl(s[3], 45);
+	return r;
+}
+
+// fill the state from seed with splitmix64, which never leaves it all zero
+static inline void rng_seed(struct rng *g, unsigned long long seed)
+{
+	unsigned long long z;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		z = (seed += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		g->s[i] = z ^ (z >> 31);
+	}
+}
+
+// uniform in [0,n)
+static inline int rng_below(struct rng *g, int n)
+{
+	return (int)(((rng_next(g) >> 32) * (unsigned long long)n) >> 32);
+}
+
 #endif
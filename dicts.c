@@ -29,7 +29,7 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include <wchar.h>
 #include <pcre.h>
-#include <glib.h>   // required for string conversion functions
+#include <limits.h>
 
 #include <dlfcn.h>
 #include <iconv.h>
@@ -202,7 +202,7 @@ static size_t load_dict(const char *fn, int dn)
 			break;
 
 		word = strtok(line, delim);
-		score_str = strtok(NULL, delim);
+		score_str = word && *word != ';' ? strtok(NULL, delim) : NULL;
 		if (score_str) {
 			score = strtoull(score_str, NULL, 10);
 			if (score == ULLONG_MAX)
@@ -221,7 +221,7 @@ static size_t load_dict(const char *fn, int dn)
 			break;
 
 		word = strtok(line, delim);
-		if (!word)
+		if (!word || *word == ';') // blank or comment line
 			goto next;
 
 		word_latin = calloc(strlen(word) + 1, 1);
@@ -517,6 +517,18 @@ int isword(const char*s) {
   return 0;
   }
 
+// score of answer s in *f; returns 0 if s is not an answer
+int ansscore(const char*s,double*f) {
+  int i,p;
+  unsigned int h;
+  h=0;
+  for(i=0;s[i];i++) h=h*113+s[i];
+  h=h%HTABSZ;
+  for(p=ahtab[h];p!=-1;p=ansp[p]->ahlink)
+    if(!strcmp(s,ansp[p]->ul)) {*f=ansp[p]->score; return 1;}
+  return 0;
+  }
+
 // add light to feasible list: s=text of light, a=answer from which treated, e=entry method
 // returns 0 if OK, !=0 on (out of memory) error
 static int addlight(const char*s,int a,int e) {
@@ -793,9 +805,9 @@ int postgetinitflist(void) {
 
 // construct an initial list of feasible lights for a given length etc.
 // caller's responsibility to free(*l)
-// returns !=0 on error; -5 on abort
+// returns !=0 on error; -5 on abort, with *l holding the lights found so far
 int getinitflist(int**l,int*ll,struct lprop*lp,int llen) {
-  int i,j,u;
+  int i,j,u,ab=0;
   ABM mfl[NMSG],ml[NMSG],b;
 
   ntfl=0;
@@ -830,6 +842,7 @@ DEB2 {
     printf("\n");
     }
     for(i=0;i<atotal;i++) {
+      if((i&1023)==0&&abort_flag) {ab=1;goto ex0;} // hand back what has been found so far
       curans=i;
       if((curdm&ansp[curans]->dmask)==0) continue; // not in a valid dictionary
       if(curten) u=treatans(ansp[curans]->ul);
@@ -850,5 +863,12 @@ ex0:
   memcpy(*l,tfl,ntfl*sizeof(int));
   *ll=ntfl;
   DEB2 printf("%d entries\n",ntfl);
-  return 0;
+  return ab?-5:0;
+  }
+
+#ifdef KBENCH
+// find light l again from its string, answer and entry method, for kbench
+int kb_findlight(int l) {
+  return findlight(lts[l].s,lts[l].tagged,lts[l].ans,lts[l].em);
   }
+#endif
@@ -45,10 +45,14 @@ extern int ultotal;               // total uniquified lights
 extern int loaddicts(int sil);
 extern void freedicts(void);
 extern int loaddefdicts(void);
+extern int ansscore(const char*s,double*f);
 extern int getinitflist(int**l,int*ll,struct lprop*lp,int wlen);
 extern int pregetinitflist(void);
 extern int postgetinitflist(void);
 extern char*loadtpi(void);
 extern void unloadtpi(void);
+#ifdef KBENCH
+extern int kb_findlight(int l);
+#endif
 
 #endif
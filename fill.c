@@ -35,7 +35,10 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 #include <wchar.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <errno.h>
+#include <signal.h>
+#include <getopt.h>
 
 #include "common.h"
 #include "filler.h"
@@ -46,6 +49,8 @@ void stepforw(int*x,int*y,int d);
 int read_grid(FILE *fp);
 void accept_hints();
 void print_grid();
+static void grid_row(char *s, int j, const ABM *fl);
+void write_stats(const char *fn, double dictms);
 
 #define fserror(x) exit(0)
 
@@ -69,10 +74,12 @@ char gauthor[SLEN]="";
 
 // these are not saved:
 int debug=0;
+volatile sig_atomic_t abort_flag=0; // set by SIGINT or SIGTERM to cancel a fill
 
 int curx=0,cury=0,dir=0;         // cursor position, and direction: 0=to right, 1=down
 int unsaved=0;                   // edited-since-save flag
 int cwperm[NL-1];
+struct rng crng;
 
 int ndir[NGTYPE]={2,3,3,2,2, 2,2,2,2,2};  // number of directions per grid type
 int gshape[NGTYPE]={0,1,2,3,4,0,0,0,0,0};  // basic shape of grid
@@ -1075,9 +1082,9 @@ static void resetstate(void) {int i,j,k,u0,u1;
   bldstructs();
   // generate "codeword" permutation
   for(i=0;i<26;i++) cwperm[i]=i;
-  for(i=0;i<1000;i++) {u0=rand()%26; u1=rand()%26; j=cwperm[u0]; cwperm[u0]=cwperm[u1]; cwperm[u1]=j;}
+  for(i=0;i<1000;i++) {u0=rng_below(&crng,26); u1=rng_below(&crng,26); j=cwperm[u0]; cwperm[u0]=cwperm[u1]; cwperm[u1]=j;}
   for(i=0;i<10;i++) cwperm[i+26]=i;
-  for(i=0;i<1000;i++) {u0=rand()%10+26; u1=rand()%10+26; j=cwperm[u0]; cwperm[u0]=cwperm[u1]; cwperm[u1]=j;}
+  for(i=0;i<1000;i++) {u0=rng_below(&crng,10)+26; u1=rng_below(&crng,10)+26; j=cwperm[u0]; cwperm[u0]=cwperm[u1]; cwperm[u1]=j;}
   }
 
 // FILE SAVE/LOAD
@@ -1117,11 +1124,10 @@ void a_filenew(int flags) {
 extern char*optarg;
 extern int optind,opterr,optopt;
 
-int main(int argc,char*argv[]) {
-
-	int i,nd;
+// set up the character tables, an empty grid and no dictionaries
+void initfill(void) {
+	int i;
 
-	srand((int)time(0));
 	for(i=0;i<26;i++) ltochar[i]   =i+'A',chartol[i   +'A']=i,chartol[i+'a']=i,chartoabm[i   +'A']=1ULL<<i,chartoabm[i+'a']=1ULL<<i;
 	for(i=0;i<10;i++) ltochar[i+26]=i+'0',chartol[i   +'0']=i+26              ,chartoabm[i   +'0']=1ULL<<(i+26);
 	ltochar[36]  =  '-',chartol[(int)'-']=36                ,chartoabm[(int)'-']=1ULL<<36;
@@ -1130,22 +1136,89 @@ int main(int argc,char*argv[]) {
 	for(i=0;i<MAXNDICTS;i++) strcpy(dsfilters[i],"");
 	for(i=0;i<MAXNDICTS;i++) strcpy(dafilters[i],"");
 	freedicts();
+	}
+
+// read a grid from fp and build its words and entries; returns !=0 on error
+int loadgrid(FILE *fp) {
+	if(read_grid(fp)) return 1;
+	bldstructs();
+	return 0;
+	}
+
+#ifndef NOMAIN // kbench.c and synth.c have their own main()
+enum { OPT_TIMEOUT=256, OPT_MAXNODES, OPT_BRANCH, OPT_FILLS, OPT_SAC, OPT_COMPONENTS, OPT_ALLDIFF, OPT_NOGOODS, OPT_CHRONO, OPT_STATS, OPT_PROGRESS, OPT_SEED };
+
+static const struct option longopts[]={
+  {"timeout",  required_argument,0,OPT_TIMEOUT },
+  {"max-nodes",required_argument,0,OPT_MAXNODES},
+  {"branch",   required_argument,0,OPT_BRANCH  },
+  {"fills",    required_argument,0,OPT_FILLS   },
+  {"sac",      required_argument,0,OPT_SAC     },
+  {"components",no_argument,     0,OPT_COMPONENTS},
+  {"alldiff",  no_argument,      0,OPT_ALLDIFF },
+  {"nogoods",  no_argument,      0,OPT_NOGOODS },
+  {"chrono",   no_argument,      0,OPT_CHRONO  },
+  {"stats",    required_argument,0,OPT_STATS   },
+  {"progress", required_argument,0,OPT_PROGRESS},
+  {"seed",     required_argument,0,OPT_SEED    },
+  {"help",     no_argument,      0,'?'         },
+  {0,0,0,0}
+  };
+
+static void onsignal(int sig) {abort_flag=1;}
+
+int main(int argc,char*argv[]) {
+
+	int i,nd,ps;
+	char*sfn;
+	struct timespec t0,t1;
+	struct sigaction sa;
+	double dms;
+
+	filler_seed=time(0);
+	rng_seed(&crng,filler_seed);
+	initfill();
 
 	nd=0;
 	i=0;
-	for(;;) switch(getopt(argc,argv,"d:?D:")) {
+	ps=0;
+	sfn=0;
+	for(;;) switch(getopt_long(argc,argv,"d:?D:g:j:r:sw",longopts,0)) {
 		case -1: goto ew0;
 		case 'd':
 			 if(strlen(optarg)<SLEN&&nd<MAXNDICTS) strcpy(dfnames[nd++],optarg);
 			 break;
 		case 'D':debug=atoi(optarg);break;
+		case 'j':filler_jobs=atoi(optarg);break;
+		case 'w':filler_steal=1;break;
+		case 'r':filler_restart=atoi(optarg);break;
+		case 'g':filler_rgrowth=atof(optarg);break;
+		case 's':ps=1;break;
+		case OPT_TIMEOUT:filler_timeout=atof(optarg);break;
+		case OPT_MAXNODES:filler_maxnodes=strtoull(optarg,0,10);break;
+		case OPT_FILLS:filler_nfills=atoi(optarg);break;
+		case OPT_SAC:filler_sac=atoi(optarg);break;
+		case OPT_COMPONENTS:filler_decomp=1;break;
+		case OPT_ALLDIFF:filler_alldiff=1;break;
+		case OPT_NOGOODS:filler_nogoods=1;break;
+		case OPT_CHRONO:filler_chrono=1;break;
+		case OPT_STATS:sfn=optarg;break;
+		case OPT_PROGRESS:filler_progress=atof(optarg);break;
+		case OPT_SEED:filler_seed=strtoull(optarg,0,10);break;
+		case OPT_BRANCH:
+			if     (!strcmp(optarg,"letter")) filler_branch=0;
+			else if(!strcmp(optarg,"word"  )) filler_branch=1;
+			else if(!strcmp(optarg,"hybrid")) filler_branch=2;
+			else i=1;
+			break;
 		case '?':
 		default:i=1;break;
 	}
 
 ew0:
 	if(i) {
-		printf("Usage: %s [-d <dictionary_file>]* [qxw_file]\n",argv[0]);
+		printf("Usage: %s [-d <dictionary_file>]* [-j <jobs> [-w]] [-r <backtracks> [-g <growth>]] [-s] [--timeout <seconds>] [--max-nodes <n>] [--branch=letter|word|hybrid] [--fills <n>] [--sac <depth>] [--components] [--alldiff] [--nogoods] [--chrono] [--stats=<file>] [--progress <seconds>] [--seed <n>] [qxw_file]\n",argv[0]);
+		printf("--progress and SIGUSR1 report on a single-process search only: the workers of -j <jobs> do not report.\n");
 		printf("This is Qxw, release %s.\n\n\
 				Copyright 2011-2014 Mark Owen; Windows port by Peter Flippant\n\
 				\n\
@@ -1170,21 +1243,41 @@ ew0:
 
 
 	a_filenew(0); // reset grid
-	nd = 1;
-	strcpy(dfnames[0], "all_dict");
+	if(filler_progress>0&&filler_jobs>1&&!filler_nfills) fprintf(stderr,"--progress is single-process only: no reports with -j %d\n",filler_jobs);
+	if(!nd) { // no -d: the default dictionary
+		nd = 1;
+		strcpy(dfnames[0], "all_dict");
+		}
+	clock_gettime(CLOCK_MONOTONIC,&t0);
 	loaddicts(0);
+	clock_gettime(CLOCK_MONOTONIC,&t1);
+	dms=(t1.tv_sec-t0.tv_sec)*1e3+(t1.tv_nsec-t0.tv_nsec)/1e6;
 
+	rng_seed(&crng,filler_seed); // read_grid() redoes the codeword permutation
 	read_grid(stdin);
 
+	// from here on, an interrupt stops the fill cleanly, keeping what it has found
+	memset(&sa,0,sizeof(sa));
+	sa.sa_handler=onsignal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT,&sa,0);
+	sigaction(SIGTERM,&sa,0);
+
 	bldstructs();
 	filler_init(1);
 	filler_search();
-	accept_hints();
-	print_grid();
+	if(!filler_nfills) { // enumerated fills are printed as they are found
+		accept_hints();
+		print_grid();
+		}
+	if(ps||filler_status==-5) filler_pstats(stderr);
+	if(sfn) write_stats(sfn,dms);
 	filler_destroy();
 	freedicts();
-	return 0;
+	if(filler_status==-5) return 130; // interrupted, partial grid printed
+	return filler_status==-6?2:0; // 2: budget used up, partial grid printed
 }
+#endif
 
 
 
@@ -1230,6 +1323,29 @@ void mkfeas(void) {int l,x,y; int*p; struct word*w=0;
 //  DEB1 printf("mkfeas: %d matches; dm=%08x\n",llistn,llistdm);
   }
 
+// called by filler with each new fill when enumerating
+void report_fill(int n) {
+  update_grid();
+  accept_hints();
+  printf("fill %d:\n",n);
+  print_grid();
+  printf("\n");
+  fflush(stdout);
+  }
+
+// called from the filler's reporter thread with a snapshot of a running search
+void report_progress(const ABM*fl,int dep,unsigned long long nodes,double rate) {
+  char s[MXSZ+1];
+  int j;
+
+  fprintf(stderr,"progress: depth %d, %llu nodes, %.0f nodes/s\n",dep,nodes,rate);
+  for(j=0;j<height;j++) {
+    grid_row(s,j,fl);
+    fprintf(stderr,"%s\n",s);
+    }
+  fprintf(stderr,"\n");
+  }
+
 // provide progress info to display
 void update_grid(void)
 {
@@ -1258,7 +1374,7 @@ int read_grid(FILE *fp)
 		while (strlen(grid) && isspace(grid[strlen(grid)-1]))
 			grid[strlen(grid)-1] = '\0';
 
-		if (!strlen(grid))
+		if (!strlen(grid) || *grid == ';') // blank or comment line
 			continue;
 
 		if (!grid_w)
@@ -1281,6 +1397,9 @@ int read_grid(FILE *fp)
 			if (grid[x] == '#') {
 				gsq[x][y].fl |= 1;
 				gsq[x][y].merge = 0;
+			} else if (grid[x] == '*') { // not part of the grid
+				gsq[x][y].fl |= 8;
+				gsq[x][y].merge = 0;
 			} else if (grid[x] != '.') {
 				gsq[x][y].ctbm[0][0] = chartoabm[(int)grid[x]];
 			}
@@ -1320,22 +1439,82 @@ void accept_hints()
 	}
 }
 
-void print_grid()
+// write row j of the grid as print_grid() shows it to s; if fl is not NULL, show the
+// feasible letters fl[] of the entries instead, with '.' where more than one remains
+static void grid_row(char *s, int j, const ABM *fl)
 {
+	struct entry *e;
 	char ch;
+	int i;
 
-	int i, j;
-	for (j = 0; j < height; j++) {
-		for(i = 0; i < width; i++) {
-			if (!isingrid(i, j) || !isownmergerep(i, j))
-				continue;
+	for(i = 0; i < width; i++) {
+		if (!isingrid(i, j) || !isownmergerep(i, j))
+			continue;
 
-			ch = getechar(i, j);
+		ch = getechar(i, j);
+		e = gsq[i][j].e0;
+		if (ch && fl && e) {
+			ch = abmtoechar(fl[e - entries]);
 			if (ch == ' ')
-				ch = gsq[i][j].fl ? '#' : '?';
-
-			printf("%c", ch);
+				ch = '.';
 		}
-		printf("\n");
+		else if (ch == ' ')
+			ch = (gsq[i][j].fl & 8) ? '*' : gsq[i][j].fl ? '#' : '?';
+
+		*s++ = ch;
+	}
+	*s = '\0';
+}
+
+void print_grid()
+{
+	char s[MXSZ+1];
+	int j;
+
+	for (j = 0; j < height; j++) {
+		grid_row(s, j, NULL);
+		printf("%s\n", s);
+	}
+}
+
+// write a JSON record of the run, with the grid and the filler's counters, to file fn
+void write_stats(const char *fn, double dictms)
+{
+	char s[MXSZ+1];
+	struct rusage ru, rc;
+	double f, q;
+	FILE *fp;
+	int i, j, n;
+
+	fp = fopen(fn, "w");
+	if (!fp) {
+		fprintf(stderr, "cannot write %s: %s\n", fn, strerror(errno));
+		return;
+	}
+	fprintf(fp, "{\"status\": %d, \"seed\": %llu, \"width\": %d, \"height\": %d, \"grid\": [", filler_status, filler_seed, width, height);
+	for (j = 0; j < height; j++) {
+		grid_row(s, j, NULL);
+		fprintf(fp, "%s\"%s\"", j ? ", " : "", s);
+	}
+	fprintf(fp, "], \"dict_ms\": %.3f, \"dict_answers\": %d, ", dictms, atotal);
+
+	// fill quality: the mean dictionary score of the words in the grid, on the log scale of load_dict()
+	for (i = 0, n = 0, q = 0; i < nw; i++) {
+		for (j = 0; j < words[i].nent && onebit(words[i].e[j]->flbmh); j++)
+			s[j] = abmtoechar(words[i].e[j]->flbmh);
+		s[j] = '\0';
+		if (j == words[i].nent && ansscore(s, &f))
+			q += log10(f), n++;
 	}
+	if (n)
+		fprintf(fp, "\"quality\": %.4f, \"words_scored\": %d, ", q / n, n);
+	else
+		fprintf(fp, "\"quality\": null, \"words_scored\": 0, ");
+
+	getrusage(RUSAGE_SELF, &ru);
+	getrusage(RUSAGE_CHILDREN, &rc); // parallel workers
+	fprintf(fp, "\"maxrss_kb\": %ld, \"stats\": ", ru.ru_maxrss > rc.ru_maxrss ? ru.ru_maxrss : rc.ru_maxrss);
+	filler_jstats(fp);
+	fprintf(fp, "}\n");
+	fclose(fp);
 }
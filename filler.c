@@ -43,31 +43,216 @@ Fifth Floor, Boston, MA  02110-1301, USA.
    getposs();
    */
 
-#include <glib.h>
-#include <gdk/gdk.h>
+#include <float.h>
 #include "common.h"
 #include "filler.h"
 #include "dicts.h"
 #include <stdbool.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 // 0 = stopped, 1 = filling all, 2 = filling selection, 3 = word lists only (for preexport)
 static int fillmode;
 
-// return code: -5: aborted; -3, -4: initflist errors; -2: out of stack; -1: out of memory; 0: stopped; 1: no fill found; 2: fill found; 3: running
+// number of independent portfolio searches to run; <=1 searches in this process only
+int filler_jobs = 1;
+
+// nonzero: the filler_jobs workers split one search tree between them instead of racing
+int filler_steal;
+
+// restarts: give up on an attempt after filler_restart backtracks times the Luby sequence
+// 1,1,2,1,1,2,4,... or, if filler_rgrowth>1, times filler_rgrowth to the power of the attempt
+// number; 0 = never restart
+int filler_restart;
+double filler_rgrowth;
+static unsigned long long *rsnodes; // nodes searched in each attempt
+static int nrsnodes,rsnodescap;
+
+// enumeration: if nonzero, report up to filler_nfills fills using distinct sets of words
+int filler_nfills;
+static unsigned long long *fhash;  // open-addressed set of fill hashes, 0 = empty slot
+static int fhashcap,nfhash;
+
+// random numbers for the search, from filler_seed; forked workers each reseed their copy
+unsigned long long filler_seed;
+static struct rng frng;
+
+// entry ordering used by findcritent(): 0 = by checking level, then crux; 1 = by crux alone
+static int critmode;
+
+// return code: -6: search budget used up; -5: aborted; -3, -4: initflist errors; -2: out of stack; -1: out of memory; 0: stopped; 1: no fill found; 2: fill found; 3: running
 int filler_status;
 
+// search budget: give up after filler_timeout seconds or filler_maxnodes nodes; 0 = no limit
+double filler_timeout;
+unsigned long long filler_maxnodes;
+static struct timespec deadline;
+static unsigned int npoll;
+static ABM *sbest;                 // feasible letters when most entries were fixed, for a partial grid
+static int nbest;                  // number of entries fixed in sbest, or -1
+static int bestdep;                // deepest level at which note_best() has looked, or -1
+
+// progress: while search() runs in this process, a reporter thread prints the partial fill on
+// SIGUSR1 and, if filler_progress>0, every filler_progress seconds; search() copies its state
+// into prfl at the next node whenever prwant is set, so the reporter never sees it mid-change
+double filler_progress;
+static pthread_t prthread;
+static pthread_mutex_t prlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prcond = PTHREAD_COND_INITIALIZER;
+static volatile int prwant;        // snapshot asked for and not yet taken
+static int prstate;                // 0 = no reporter, 1 = running, 2 = told to stop
+static ABM *prfl;                  // snapshot: feasible letters of each entry
+static int prdep;                  // snapshot: search depth
+static unsigned long long prnodes; // snapshot: nodes so far
+
 // the following stacks keep track of the filler state as it recursively tries to fill the grid
 static int sdep = -1; // stack pointer
 
 static char **sposs;               // possibilities for this entry, 0-terminated
 static int *spossp;                // which possibility we are currently trying (index into sposs)
-static int ***sflist;              // pointers to restore feasible word list flist
-static int **sflistlen;            // pointers to restore flistlen
+static int **sflistlen;            // live flist lengths to restore on backtrack
 static ABM **sentryfl;             // feasible letter bitmap for this entry
 static int *sentry;                // entry considered at this depth
-
-static unsigned char *aused;       // answer already used while filling
-static unsigned char *lused;       // light already used while filling
+static int *sword;                 // word whose candidates are tried at this depth, or -1 to try letters of sentry
+static int **swcand;               // candidates for sword, in order, one per distinct string
+static int *swcandn,*swcandcap;
+
+// branching: 0 = on the letters of the critical entry, 1 = on the candidates of the word with
+// the shortest list, 2 = on that word only when it has no more candidates than the entry has letters
+int filler_branch;
+static int *uqstamp,uqgen;         // marks distinct strings while collecting word candidates
+struct cand {
+	double f;
+	int l;
+};
+static struct cand *cbuf;          // getcands() scratch
+static int cbufcap;
+
+// lookahead: at depths below filler_sac, try each letter of the critical entry with propagation
+// alone and remove those that fail before branching; 0 = off
+int filler_sac;
+static int sacing;                 // set while a probe is being propagated
+static int *sactrail,nsactrail;    // words whose lists the probe has saved, for sac_pop()
+static unsigned long long *sacrs;  // levels the failed probes depended on
+
+// decomposition: once the unfixed entries fall into connected components, linked by the words
+// they share, keep branching within the component of the first entry chosen until it is
+// filled, so that a failure in another component never undoes it; with filler_jobs>1, a grid
+// already in pieces at the root has its components filled by separate workers
+int filler_decomp;
+static int *cpar;                  // union-find parent per entry
+static int *ccomp;                 // component of each unfixed entry, or -1
+static int *csize;                 // entries in each component
+static unsigned char **sfocus;     // entries of the component being filled at each depth
+static unsigned char *cmask;       // entries findcritent() may choose from, or NULL for any
+
+// propagation worklists: entries whose flbm changed and words whose flist changed
+static int *ewoff;                 // words containing entry i are ewlist[ewoff[i]..ewoff[i+1])
+static int *ewlist;
+static int *entq, nentq;           // entries with upd set, awaiting settleents()
+static int *wdq, nwdq;             // words with upd set, awaiting settlewds()
+static int *wtouch;                // words to refilter in the current settleents() pass
+static unsigned char *wtouched;
+
+// support counts: wsup[i][k*NL+c] is the number of live candidates of word i with letter c at
+// position k; wlost[i][k] collects letters whose count has dropped to zero since settlewds().
+// Counts are kept (wsupok[i] set) while a list has at least SUPMIN live candidates and changes
+// touch fewer candidates than remain; otherwise the list is cheaper to rescan in settlewds(),
+// which then recounts it.
+#define SUPMIN 64
+static int **wsup;
+static ABM **wlost;
+static unsigned char *wsupok;
+static int nwsup;                  // number of words wsup[] and wlost[] were allocated for
+
+// conflict-directed backjumping: sets of decision levels (bit d = the letter tried at sposs[d]),
+// nrw words each. reason[] holds one set per entry then one per word, naming the levels whose
+// decisions led to the removals made so far; sconf[d] collects what the children of level d failed on
+#define ENTRS(i) (reason+(i)*nrw)
+#define WORDRS(i) (reason+(ne+(i))*nrw)
+static int nrw;
+static unsigned long long *reason;
+static unsigned long long **sreason; // reason[] saved at each depth
+static unsigned long long **sconf;
+static unsigned long long *rconf;  // levels responsible for the current failure
+int filler_chrono;                 // blame every level for every failure: plain chronological backtracking
+
+// nogood learning: each failure whose conflict set names at most NGLEN decisions is kept as a
+// set of (entry, letter) pairs that cannot all hold together, found by Zobrist hash and evicted
+// least recently used first; every nogood is on the watch list of each of its entries.
+// Only with filler_nogoods (--nogoods): the table is not allocated otherwise
+int filler_nogoods;
+#define NGLEN 8
+#define NGMAX 16384
+#define NGHASH 32768
+struct nogood {
+	unsigned long long h;
+	int n;
+	int e[NGLEN];
+	ABM m[NGLEN];
+	int hnext;                    // hash chain
+	int lprev,lnext;              // LRU list, most recent first
+	int wprev[NGLEN],wnext[NGLEN]; // watch lists: links are nogood*NGLEN+pair index
+};
+static struct nogood *ngs;
+static int *nghash;
+static int *ngwatch;               // first watch link for each entry
+static int nglru,ngold;            // most and least recently used
+static int ngused;                 // slots of ngs[] handed out so far; ngs[] is not touched beyond this
+
+struct filler_stats filler_stats;
+
+// work-stealing state shared between forked workers; see steal()
+struct wshared {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int nworkers;
+	volatile int idle;     // workers waiting for a job
+	volatile int njob;     // jobs in the pool
+	volatile int done;     // set once the search is over
+	int cap;               // size of the pool
+	int status;            // search() result when done
+	int nbest;             // entries fixed in wfill[] if status is -6, or -1
+	struct filler_stats st; // summed over workers
+};
+static struct wshared *wsh; // NULL unless this process is a work-stealing worker
+static int *wjobs;          // pool: job j is wjobs[j*(2*ne+1)]: n, then n (entry, letter index) pairs
+static ABM *wfill;          // winning worker's flbm per entry
+static int *jpath, jlen;    // (entry, letter index) pairs fixed by this worker's current job
+static ABM *jfix;          // scratch for donate()
+
+static int *aused;                 // 1 + index of word using answer while filling, or 0
+static int *lused;                 // 1 + index of word using light while filling, or 0
+
+// used-word pruning (afunique): each candidate keeps the slot it had in its word's list as
+// built; fslot[i][p] is the slot of the candidate at position p of words[i].flist and fpos[i][s]
+// the position of slot s. uwlist[uwoff[u]..uwoff[u+1]) holds the (word, slot) pairs of the
+// lights with string u, awlist/awoff the same by answer, so committing a word can take its
+// lights straight out of the other lists
+static int **fslot, **fpos;
+static int nfslot;                 // number of words fslot[] and fpos[] were allocated for
+static int *uwoff, *uwlist, *awoff, *awlist;
+
+// all-different (afunique): the uncommitted words with at most ADMAX live candidates are matched
+// to distinct strings; a word left unmatched refutes the node, and the strings of a set of words
+// with no more strings between them than words are taken out of every other list
+#define ADMAX 16
+int filler_alldiff;
+static int *adw, nadw;             // words taking part
+static int *adadj, *adn;           // adadj[i*ADMAX..] the adn[i] distinct strings of adw[i]
+static int *adwmate;               // string matched to adw[i]
+static unsigned char *adreach;     // adw[i] reachable from an unmatched string
+static unsigned char *adin;        // per word: in the Hall set being pruned
+static int *admate;                // index into adw matched to each string, if adstamp is current
+static unsigned int *adstamp, adgen;
+static unsigned int *advis, advgen; // strings visited by the current augmenting search
+static int *advl, nadvl;           // ... in order
+static unsigned long long *adrs;   // reasons for the Hall set
 
 #define isused(l) (lused[lts[l].uniq] | aused[lts[l].ans+NMSG])
 #define setused(l,v) do { \
@@ -109,8 +294,10 @@ static void pstate(int f) {
 // find the entry to expand next, or -1 if all done
 static int findcritent(void) {int i,j,m;double k,l;
 	m = -1;
-	for(i = 0;i<ne;i++) {
+	if (critmode == 1) m = 1; // treat all entries as one checking level
+	else for(i = 0;i<ne;i++) {
 		if (fillmode == 2&&entries[i].sel == 0) continue; // filling selection only: only check relevant entries
+		if (cmask&&!cmask[i]) continue; // another component
 		if (onebit(entries[i].flbm)) continue;
 		if (entries[i].checking>m) m = entries[i].checking; // find highest checking level // find highest checking level
 	}
@@ -119,6 +306,7 @@ static int findcritent(void) {int i,j,m;double k,l;
 		j = -1;l = DBL_MAX;
 		for(i = 0;i<ne;i++) {
 			if (fillmode == 2&&entries[i].sel == 0) continue; // filling selection only: only check relevant entries
+			if (cmask&&!cmask[i]) continue;
 			if (!onebit(entries[i].flbm)&&entries[i].checking >= m) { // not already fixed?
 				k = entries[i].crux; // get the priority for this entry
 				if (k<l) l = k,j = i;}
@@ -129,32 +317,386 @@ static int findcritent(void) {int i,j,m;double k,l;
 }
 
 /*
- * Return true if any entries for a given word have been updated.
+ * Flag an entry whose feasible letters have narrowed, queueing it for
+ * the next settleents() pass.
+ */
+static inline void mark_entry(struct entry *e)
+{
+	if (e->upd)
+		return;
+	e->upd = 1;
+	entq[nentq++] = e - entries;
+	filler_stats.entq_pushes++;
+}
+
+/*
+ * Flag a word whose feasible list has shrunk, queueing it for the
+ * next settlewds() pass.
  */
-static bool word_has_updates(struct word *word)
+static inline void mark_word(struct word *w)
+{
+	if (w->upd)
+		return;
+	w->upd = 1;
+	wdq[nwdq++] = w - words;
+	filler_stats.wdq_pushes++;
+}
+
+/* drop anything still queued, e.g. after propagation proved infeasible */
+static void flush_queues(void)
 {
 	int i;
 
-	for (i = 0; i < word->nent; i++) {
-		if (word->e[i]->upd)
-			return true;
+	for (i = 0; i < nentq; i++)
+		entries[entq[i]].upd = 0;
+	for (i = 0; i < nwdq; i++) {
+		words[wdq[i]].upd = 0;
+		if (wlost[wdq[i]])
+			memset(wlost[wdq[i]], 0, words[wdq[i]].nent * sizeof(ABM));
+	}
+	nentq = nwdq = 0;
+}
+
+/* queue everything, as nothing is yet known to be consistent */
+static void mark_all(void)
+{
+	int i;
+
+	flush_queues();
+	for (i = 0; i < ne; i++)
+		entries[i].upd = 0, mark_entry(entries + i);
+	for (i = 0; i < nw; i++)
+		words[i].upd = 0, mark_word(words + i);
+}
+
+static inline unsigned long long now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+static inline void rs_or(unsigned long long *d, const unsigned long long *s)
+{
+	int i;
+
+	for (i = 0; i < nrw; i++)
+		d[i] |= s[i];
+}
+
+/* deepest level in a reason set, or -1 if it is empty */
+static int rs_max(const unsigned long long *s)
+{
+	int i;
+
+	for (i = nrw - 1; i >= 0; i--)
+		if (s[i])
+			return i * 64 + 63 - __builtin_clzll(s[i]);
+	return -1;
+}
+
+static unsigned long long zobrist(int e, ABM m)
+{
+	unsigned long long z;
+
+	z = (unsigned long long)e * NL + __builtin_ctzll(m) + 0x9e3779b97f4a7c15ULL; // splitmix64
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static void ng_reset(void)
+{
+	int i;
+
+	for (i = 0; i < NGHASH; i++)
+		nghash[i] = -1;
+	for (i = 0; i < ne; i++)
+		ngwatch[i] = -1;
+	ngused = 0;
+	nglru = ngold = -1;
+}
+
+static void ng_lru_unlink(int g)
+{
+	struct nogood *p = ngs + g;
+
+	if (p->lprev >= 0) ngs[p->lprev].lnext = p->lnext;
+	else nglru = p->lnext;
+	if (p->lnext >= 0) ngs[p->lnext].lprev = p->lprev;
+	else ngold = p->lprev;
+}
+
+static void ng_lru_front(int g)
+{
+	ngs[g].lprev = -1;
+	ngs[g].lnext = nglru;
+	if (nglru >= 0) ngs[nglru].lprev = g;
+	nglru = g;
+	if (ngold < 0) ngold = g;
+}
+
+/* drop the least recently used nogood, returning its slot */
+static int ng_evict(void)
+{
+	int g, k, l, *pp;
+	struct nogood *p;
+
+	g = ngold;
+	p = ngs + g;
+	ng_lru_unlink(g);
+	for (pp = nghash + (p->h & (NGHASH - 1)); *pp != g; pp = &ngs[*pp].hnext)
+		;
+	*pp = p->hnext;
+	for (k = 0; k < p->n; k++) {
+		l = p->wprev[k];
+		if (l >= 0) ngs[l / NGLEN].wnext[l % NGLEN] = p->wnext[k];
+		else ngwatch[p->e[k]] = p->wnext[k];
+		l = p->wnext[k];
+		if (l >= 0) ngs[l / NGLEN].wprev[l % NGLEN] = p->wprev[k];
 	}
-	return false;
+	filler_stats.ng_evicted++;
+	return g;
 }
 
 /*
- * Find all lights in the list of light indices whose character at
- * index wp satisfies feasible letter bitmap m and copy them to the
- * front of p.  Return the length of the new valid list.
+ * Write the (entry, letter) pairs set by the decision at level k < sdep
+ * to e[] and m[], at most max of them.  A word decision counts only the
+ * entries it fixed.  Returns the number of pairs, or -1 if too many.
  */
-static int listisect(int *p, int *lights, int lights_len, int wp, ABM m)
+static int level_pairs(int k, int *e, ABM *m, int max)
 {
-	int i, j;
-	for (i = 0, j = 0; i < lights_len; i++)
-		if (m & (chartoabm[(int)(lts[lights[i]].s[wp])]))
-			p[j++] = lights[i];
+	struct word *w;
+	const char *t;
+	int j, n;
+
+	if (sword[k] < 0) {
+		if (max < 1)
+			return -1;
+		e[0] = sentry[k];
+		m[0] = chartoabm[(int)sposs[k][spossp[k] - 1]];
+		return 1;
+	}
+	w = words + sword[k];
+	t = lts[swcand[k][spossp[k] - 1]].s;
+	for (j = 0, n = 0; j < w->nent; j++) {
+		if (onebit(sentryfl[k + 1][w->e[j] - entries]))
+			continue;
+		if (n == max)
+			return -1;
+		e[n] = w->e[j] - entries;
+		m[n++] = chartoabm[(int)t[j]];
+	}
+	return n;
+}
+
+/* record the decisions at the levels in rconf as a nogood */
+static void ng_learn(void)
+{
+	int e[NGLEN];
+	ABM m[NGLEN];
+	unsigned long long h;
+	struct nogood *p;
+	int g, j, k, n;
+
+	for (k = 0, n = 0; k < sdep; k++) {
+		if (!(rconf[k / 64] >> (k % 64) & 1))
+			continue;
+		j = level_pairs(k, e + n, m + n, NGLEN - n);
+		if (j < 0)
+			return; // too far-reaching to be worth keeping
+		n += j;
+	}
+	if (n == 0)
+		return;
+	for (k = 0, h = 0; k < n; k++)
+		h ^= zobrist(e[k], m[k]);
+	for (g = nghash[h & (NGHASH - 1)]; g >= 0; g = ngs[g].hnext)
+		if (ngs[g].h == h && ngs[g].n == n) { // already known
+			ng_lru_unlink(g);
+			ng_lru_front(g);
+			return;
+		}
+	if (ngused < NGMAX)
+		g = ngused++;
+	else
+		g = ng_evict();
+	p = ngs + g;
+	p->h = h;
+	p->n = n;
+	memcpy(p->e, e, n * sizeof(int));
+	memcpy(p->m, m, n * sizeof(ABM));
+	p->hnext = nghash[h & (NGHASH - 1)];
+	nghash[h & (NGHASH - 1)] = g;
+	ng_lru_front(g);
+	for (k = 0; k < n; k++) {
+		p->wprev[k] = -1;
+		p->wnext[k] = ngwatch[e[k]];
+		if (p->wnext[k] >= 0)
+			ngs[p->wnext[k] / NGLEN].wprev[p->wnext[k] % NGLEN] = g * NGLEN + k;
+		ngwatch[e[k]] = g * NGLEN + k;
+	}
+	filler_stats.ng_learnt++;
+}
+
+/*
+ * Check the nogoods watching entries fixed since the last push.  A
+ * nogood that holds is a dead end seen before: set rconf to the levels
+ * behind its entries and return -2.  One that is a single pair short
+ * of holding rules that letter out of its entry.  Otherwise return the
+ * number of letters removed.
+ */
+static int ng_propagate(void)
+{
+	struct nogood *p;
+	struct entry *x;
+	int e, f, g, k, l, u;
+
+	f = 0;
+	for (e = 0; e < ne; e++) {
+		if (!onebit(entries[e].flbm) || onebit(sentryfl[sdep][e]))
+			continue;
+		for (l = ngwatch[e]; l >= 0; l = p->wnext[l % NGLEN]) {
+			g = l / NGLEN;
+			p = ngs + g;
+			filler_stats.ng_checks++;
+			for (k = 0, u = -1; k < p->n; k++) {
+				if (entries[p->e[k]].flbm == p->m[k])
+					continue;
+				if (u >= 0 || !(entries[p->e[k]].flbm & p->m[k]))
+					break;
+				u = k;
+			}
+			if (k < p->n)
+				continue;
+			memset(rconf, 0, nrw * sizeof(*rconf));
+			for (k = 0; k < p->n; k++)
+				if (k != u)
+					rs_or(rconf, ENTRS(p->e[k]));
+			ng_lru_unlink(g);
+			ng_lru_front(g);
+			if (u < 0) {
+				filler_stats.ng_hits++;
+				return -2;
+			}
+			x = entries + p->e[u];
+			x->flbm &= ~p->m[u];
+			rs_or(ENTRS(p->e[u]), rconf);
+			mark_entry(x);
+			filler_stats.ng_prunes++;
+			f++;
+		}
+	}
+	return f;
+}
+
+/*
+ * Each word's flist is a sparse set: the live candidates occupy
+ * flist[0..flistlen) and filtering swaps removed candidates past the
+ * live boundary, so restoring an earlier flistlen on backtrack brings
+ * them all back without copying.
+ */
+static inline void flist_remove(struct word *w, int i, int len)
+{
+	int t, *p, *s;
+
+	p = w->flist;
+	t = p[i];
+	p[i] = p[len];
+	p[len] = t;
+	if (fslot) {
+		s = fslot[w - words];
+		p = fpos[w - words];
+		t = s[i];
+		s[i] = s[len];
+		s[len] = t;
+		p[s[i]] = i;
+		p[t] = len;
+	}
+	filler_stats.cands_removed++;
+}
+
+/* add d to the support of candidates flist[from..to), noting letters whose support runs out */
+static void flist_support(struct word *w, int from, int to, int d)
+{
+	int j, k, wi;
+	int *sup;
+	const char *s;
+
+	wi = w - words;
+	for (j = from; j < to; j++) {
+		s = lts[w->flist[j]].s;
+		sup = wsup[wi];
+		for (k = 0; k < w->nent; k++, sup += NL)
+			if ((sup[chartol[(int)s[k]]] += d) == 0)
+				wlost[wi][k] |= chartoabm[(int)s[k]];
+	}
+}
+
+/*
+ * Withdraw the support of the candidates just removed from a counted
+ * list, now at flist[flistlen..len0).  If that is more work than
+ * rescanning what is left, drop the counts instead.
+ */
+static void update_support(struct word *w, int len0)
+{
+	int wi, len;
+
+	wi = w - words;
+	len = w->flistlen;
+	if (!wsupok[wi])
+		return;
+	if (len < SUPMIN || len0 - len > len) {
+		wsupok[wi] = 0;
+		return;
+	}
+	flist_support(w, len, len0, -1);
+}
+
+/* give back the support of candidates returning to the list on backtrack */
+static void restore_support(struct word *w, int len)
+{
+	int wi;
 
-	return j;
+	wi = w - words;
+	if (!wsupok[wi])
+		return;
+	if (len - w->flistlen > w->flistlen) {
+		wsupok[wi] = 0;
+		return;
+	}
+	flist_support(w, w->flistlen, len, 1);
+}
+
+/* recount the support of a list from scratch */
+static void recount_support(struct word *w)
+{
+	int wi;
+
+	wi = w - words;
+	memset(wsup[wi], 0, w->nent * NL * sizeof(int));
+	flist_support(w, 0, w->flistlen, 1);
+	wsupok[wi] = 1;
+}
+
+/*
+ * Keep only those live lights whose character at index wp satisfies
+ * feasible letter bitmap m, swapping the rest past the live boundary.
+ * Return the length of the new live list.
+ */
+static int listisect(struct word *w, int len, int wp, ABM m)
+{
+	int i;
+	int *p = w->flist;
+
+	for (i = 0; i < len; ) {
+		if (m & (chartoabm[(int)(lts[p[i]].s[wp])]))
+			i++;
+		else
+			flist_remove(w, i, --len);
+	}
+	return len;
 }
 
 /*
@@ -165,8 +707,7 @@ static int listisect(int *p, int *lights, int lights_len, int wp, ABM m)
  */
 static bool update_feasible_words(struct word *word)
 {
-	int i;
-	int *p;
+	int i, l;
 	struct entry *entry;
 	int len = word->flistlen;
 
@@ -175,7 +716,11 @@ static bool update_feasible_words(struct word *word)
 		if (!entry->upd)
 			continue;
 
-		len = listisect(word->flist, word->flist, len, i, entry->flbm);
+		l = listisect(word, len, i, entry->flbm);
+		if (l != len)
+			rs_or(WORDRS(word - words), ENTRS(entry - entries));
+		filler_stats.isect_removed += len - l;
+		len = l;
 		if (!len)
 			break;
 	}
@@ -184,56 +729,196 @@ static bool update_feasible_words(struct word *word)
 	if (len == word->flistlen)
 		return false;
 
-	word->upd = 1;
 	word->flistlen = len;
-
-	/* try to shrink list */
-	if (len) {
-		p = realloc(word->flist, word->flistlen * sizeof(int));
-		if (p)
-			word->flist = p;
-	}
+	mark_word(word);
 	return true;
 }
 
+/* save this word's live length at depth sdep before it is first filtered */
+static void stack_save_wordlist(struct word *word, int sdep, int j)
+{
+	if (sflistlen[sdep][j] != -1)
+		return;
+	sflistlen[sdep][j] = word->flistlen;
+	if (sacing)
+		sactrail[nsactrail++] = j;
+}
+
 /*
- * Remove candidates we already used from this word's list.
+ * Remove the candidate in slot s of word n's list, if still live, for
+ * reasons rs.  Returns -2 if that leaves the list empty (rconf says
+ * why), 1 if removed, otherwise 0.
  */
-static bool prune_used_words(struct word *word)
+static int drop_cand(int n, int s, const unsigned long long *rs)
 {
-	int i, len;
-
-	for (i = 0, len = 0; i < word->flistlen; i++) {
-		if (!isused(word->flist[i]))
-			word->flist[len++] = word->flist[i];
+	struct word *x;
+	int p;
+
+	x = words + n;
+	p = fpos[n][s];
+	if (p >= x->flistlen)
+		return 0;
+	stack_save_wordlist(x, sdep, n);
+	flist_remove(x, p, --x->flistlen);
+	if (wsup[n])
+		update_support(x, x->flistlen + 1);
+	rs_or(WORDRS(n), rs);
+	mark_word(x);
+	if (!x->flistlen && !x->fe) {
+		memcpy(rconf, WORDRS(n), nrw * sizeof(*rconf));
+		return -2;
 	}
-	if (len == word->flistlen)
-		return false;
+	return 1;
+}
 
-	word->flistlen = len;
-	return true;
+/*
+ * Word k has just been committed: take the lights it uses out of the
+ * other lists holding them, by string or by answer.  Returns -2 if
+ * that leaves a list empty (rconf says why), otherwise the number of
+ * candidates removed.
+ */
+static int drop_used(int k)
+{
+	struct word *w;
+	int i, j, m, r, s, *off, *lst;
+
+	w = words + k;
+	for (i = 0, m = 0; i < w->flistlen; i++) {
+		for (off = uwoff, lst = uwlist, s = lts[w->flist[i]].uniq; off; ) {
+			for (j = off[s]; j < off[s + 1]; j++) {
+				if (lst[2 * j] == k)
+					continue;
+				r = drop_cand(lst[2 * j], lst[2 * j + 1], WORDRS(k));
+				if (r == -2)
+					return -2;
+				m += r;
+			}
+			if (off == awoff)
+				break;
+			off = awoff, lst = awlist, s = lts[w->flist[i]].ans + NMSG;
+		}
+	}
+	return m;
 }
 
-static void *xmemdup(void *src, size_t size)
+/* try to match adw[i] to a string, moving earlier matches along if need be */
+static int ad_augment(int i)
 {
-	void *p = malloc(size);
-	if (!p)
-		exit(-1);
+	int j, u;
 
-	memcpy(p, src, size);
-	return p;
+	for (j = 0; j < adn[i]; j++) {
+		u = adadj[i * ADMAX + j];
+		if (advis[u] == advgen)
+			continue;
+		advis[u] = advgen;
+		advl[nadvl++] = u;
+		if (adstamp[u] != adgen || ad_augment(admate[u])) {
+			adstamp[u] = adgen;
+			admate[u] = i;
+			adwmate[i] = u;
+			return 1;
+		}
+	}
+	return 0;
 }
 
-static void stack_save_wordlist(struct word *word, int sdep, int j)
+/*
+ * All-different propagation over the words with short lists.
+ * Returns -2 if they cannot all take different strings (rconf says
+ * why), -6 if the fill was cancelled, otherwise the number of
+ * candidates removed.
+ */
+static int alldiff(void)
 {
-	/* already saved? */
-	if (sflistlen[sdep][j] != -1)
-		return;
+	struct word *w;
+	int i, j, k, m, r, u;
+	bool more;
 
-	/* save and make a new copy of list to work on */
-	sflist[sdep][j] = word->flist;
-	sflistlen[sdep][j] = word->flistlen;
-	word->flist = xmemdup(word->flist, word->flistlen * sizeof(int));
+	if (++adgen == 0) {
+		memset(adstamp, 0, ultotal * sizeof(*adstamp));
+		adgen = 1;
+	}
+	for (i = 0, nadw = 0; i < nw; i++) {
+		w = words + i;
+		if (w->fe || w->commitdep >= 0 || w->flistlen > ADMAX)
+			continue;
+		if (++advgen == 0) {
+			memset(advis, 0, ultotal * sizeof(*advis));
+			advgen = 1;
+		}
+		for (j = 0, k = 0; j < w->flistlen; j++) { // distinct strings
+			u = lts[w->flist[j]].uniq;
+			if (advis[u] == advgen)
+				continue;
+			advis[u] = advgen;
+			adadj[nadw * ADMAX + k++] = u;
+		}
+		adn[nadw] = k;
+		adw[nadw++] = i;
+	}
+	if (nadw < 2)
+		return 0;
+
+	for (i = 0; i < nadw; i++) {
+		if (abort_flag)
+			return -6;
+		if (++advgen == 0) {
+			memset(advis, 0, ultotal * sizeof(*advis));
+			advgen = 1;
+		}
+		nadvl = 0;
+		if (ad_augment(i))
+			continue;
+		// the words the search reached have fewer strings between them than there are words
+		memcpy(rconf, WORDRS(adw[i]), nrw * sizeof(*rconf));
+		for (j = 0; j < nadvl; j++)
+			rs_or(rconf, WORDRS(adw[admate[advl[j]]]));
+		filler_stats.ad_fails++;
+		return -2;
+	}
+
+	// words reachable from an unmatched string by alternating paths can
+	// give theirs up; the rest share exactly their matched strings
+	for (i = 0; i < nadw; i++)
+		adreach[i] = 0;
+	do {
+		more = false;
+		for (i = 0; i < nadw; i++) {
+			if (adreach[i])
+				continue;
+			for (j = 0; j < adn[i]; j++) {
+				u = adadj[i * ADMAX + j];
+				if (adstamp[u] != adgen || (admate[u] != i && adreach[admate[u]]))
+					break;
+			}
+			if (j < adn[i])
+				adreach[i] = 1, more = true;
+		}
+	} while (more);
+	memset(adrs, 0, nrw * sizeof(*adrs));
+	for (i = 0, k = 0; i < nadw; i++)
+		if (!adreach[i]) {
+			adin[adw[i]] = 1;
+			rs_or(adrs, WORDRS(adw[i]));
+			k++;
+		}
+	for (i = 0, m = 0, r = 0; i < nadw && k && r != -2; i++) {
+		if (adreach[i])
+			continue;
+		u = adwmate[i];
+		for (j = uwoff[u]; j < uwoff[u + 1]; j++) {
+			if (adin[uwlist[2 * j]])
+				continue;
+			r = drop_cand(uwlist[2 * j], uwlist[2 * j + 1], adrs);
+			if (r == -2)
+				break;
+			m += r;
+		}
+	}
+	for (i = 0; i < nadw; i++)
+		adin[adw[i]] = 0;
+	filler_stats.ad_prunes += m;
+	return r == -2 ? -2 : m;
 }
 
 /*
@@ -251,47 +936,78 @@ static bool all_entries_determined(struct word *word)
 
 
 /*
- * Check updated entries and rebuild feasible word lists
+ * Check updated entries and rebuild feasible word lists of the words
+ * containing them.
  * returns -3 for aborted, -2 for infeasible, -1 for out of memory, 0 if no feasible word lists affected,  >= 1 otherwise
  */
 static int settleents(void)
 {
 	struct word *w;
-	int i, j;
+	int i, j, k, n, len0;
 	bool changed = false;
+	int u;
+
+	filler_stats.ent_passes++;
+	/* collect the words crossing updated entries */
+	for (i = 0, n = 0; i < nentq; i++) {
+		for (j = ewoff[entq[i]]; j < ewoff[entq[i] + 1]; j++) {
+			k = ewlist[j];
+			if (wtouched[k])
+				continue;
+			wtouched[k] = 1;
+			wtouch[n++] = k;
+		}
+	}
 
-	for (i = 0; i < nw; i++) {
-		/* check this word for any updated entries (cells) */
-		w = &words[i];
-		if (!word_has_updates(w))
-			continue;
+	for (i = 0; i < n; i++) {
+		k = wtouch[i];
+		w = &words[k];
+		wtouched[k] = 0;
 
-		stack_save_wordlist(w, sdep, i);
+		stack_save_wordlist(w, sdep, k);
 
-		changed |= prune_used_words(w);
+		len0 = w->flistlen;
 		changed |= update_feasible_words(w);
+		if (wsup[k] && w->flistlen != len0)
+			update_support(w, len0);
 
 		/* no solution? */
-		if (!w->flistlen && !w->fe)
+		if (!w->flistlen && !w->fe) {
+			for (i++; i < n; i++)
+				wtouched[wtouch[i]] = 0;
+			flush_queues();
+			memcpy(rconf, WORDRS(k), nrw * sizeof(*rconf));
 			return -2;
+		}
 		if (!all_entries_determined(w))
 			continue;
 
 		/* fixed this word at this stack level */
 		assert(w->commitdep == -1);
 		for (j = 0; j < w->flistlen; j++)
-			setused(w->flist[j], 1);
+			setused(w->flist[j], k + 1);
 		w->commitdep = sdep;
+		if (!fslot)
+			continue;
+		u = drop_used(k);
+		if (u == -2) {
+			for (i++; i < n; i++)
+				wtouched[wtouch[i]] = 0;
+			flush_queues();
+			return -2;
+		}
+		changed |= u > 0;
 	}
 
 	/* all entry update effects now propagated into word updates */
-	for (i = 0; i < ne; i++)
-		entries[i].upd = 0;
+	for (i = 0; i < nentq; i++)
+		entries[entq[i]].upd = 0;
+	nentq = 0;
 
 	return changed;
 }
 
-// check updated word lists, rebuild feasible entry lists
+// check updated word lists, taking letters that have lost all support out of their entries
 // returns -3 for aborted, 0 if no feasible letter lists affected, >0 otherwise
 static int settlewds(void)
 {
@@ -299,43 +1015,57 @@ static int settlewds(void)
 	int *p;
 	struct entry *e;
 	struct word *w;
+	ABM *lost;
 	ABM entfl[MXFL];
 	//  DEB1 printf("settlewds()\n");
+	filler_stats.wds_passes++;
 	f = 0;
-	for (i = 0; i < nw; i++) {
-		w = words + i;
-		if (!w->upd)
-			continue;	// loop over updated word lists
-		if (w->fe)
-			continue;
+	for (i = 0; i < nwdq; i++) {
+		w = words + wdq[i];	// loop over updated word lists
+		lost = wlost[wdq[i]];
+		if (!lost)
+			continue;	// fully entered: never constrains its entries
 		m = w->nent;
-		p = w->flist;
 		l = w->flistlen;
-
-		/* compute bitmap of letters in this word's wordlist */
-		for (k = 0; k < m; k++)
-			entfl[k] = 0;
-		for (j = 0; j < l; j++)
+		if (!wsupok[wdq[i]] && l >= SUPMIN) {
+			/* long list: count it again so later changes can be incremental */
+			recount_support(w);
 			for (k = 0; k < m; k++)
-				entfl[k] |= chartoabm[(int)lts[p[j]].s[k]];	// find all feasible letters from word list
-		DEB16 {
-			printf("w = %d entfl: ", i);
+				for (j = 0; j < NL; j++)
+					if (!wsup[wdq[i]][k * NL + j])
+						lost[k] |= 1ULL << j;
+		} else if (!wsupok[wdq[i]]) {
+			/* short list: rescan for the letters it still provides */
+			p = w->flist;
+			for (k = 0; k < m; k++)
+				entfl[k] = 0;
+			for (j = 0; j < l; j++)
+				for (k = 0; k < m; k++)
+					entfl[k] |= chartoabm[(int)lts[p[j]].s[k]];	// find all feasible letters from word list
 			for (k = 0; k < m; k++)
-				printf(" %016llx", entfl[k]);
+				lost[k] = ~entfl[k];
+		}
+		DEB16 {
+			printf("w = %d lost: ", wdq[i]);
+			for (j = 0; j < m; j++)
+				printf(" %016llx", lost[j]);
 			printf("\n");
 		}
 		for (j = 0; j < m; j++) {
 			e = w->e[j];	// propagate from word to entry
-			if (e->flbm & ~entfl[j]) {	// has this entry been changed by the additional constraint?
-				e->flbm &= entfl[j];
-				e->upd = 1;
+			if (e->flbm & lost[j]) {	// has this entry been changed by the additional constraint?
+				e->flbm &= ~lost[j];
+				rs_or(ENTRS(e - entries), WORDRS(wdq[i]));
+				mark_entry(e);
 				f++;	// flag that it will need updating
 				//      printf("E%d %16llx\n",k,entries[k].flbm);fflush(stdout);
 			}
+			lost[j] = 0;
 		}
 	}
-	for (i = 0; i < nw; i++)
-		words[i].upd = 0;	// all word list updates processed
+	for (i = 0; i < nwdq; i++)
+		words[wdq[i]].upd = 0;	// all word list updates processed
+	nwdq = 0;
 	//  DEB1 printf("settlewds returns %d\n",f);fflush(stdout);
 	return f;
 }
@@ -380,8 +1110,8 @@ static int mkscores(void) {
 }
 
 
-// sort possible letters into order of decreasing favour with randomness r; write results to s
-void getposs(struct entry*e,char*s,int r,int dash) {int i,l,m,n,nl;double j,k;
+// sort possible letters into order of decreasing favour with randomness r drawn from g; write results to s
+void getposs(struct entry*e,char*s,int r,int dash,struct rng*g) {int i,l,m,n,nl;double j,k;
 	//  DEB2 printf("getposs(%d)\n",(int)(e-entries));
 	nl = dash?NL:NL-1; // avoid outputting dashes?
 	l = 0;
@@ -396,7 +1126,7 @@ void getposs(struct entry*e,char*s,int r,int dash) {int i,l,m,n,nl;double j,k;
 	s[l] = '\0';
 	if (r == 0) return;
 	for(i = 0;i<l;i++) { // randomise if necessary
-		m = i+rand()%(r*2+1); // candidate for swap: distance depends on randomisation level
+		m = i+rng_below(g,r*2+1); // candidate for swap: distance depends on randomisation level
 		if (m >= 0&&m<l) n = s[i],s[i] = s[m],s[m] = n; // swap candidates
 	}
 }
@@ -407,32 +1137,139 @@ static void sdepsp(void) {int i; if (sdep<0) printf("<%d",sdep); for(i = 0;i<sde
 static void freestack() {int i;
 	for(i = 0;i <= ne;i++) {
 		if (sposs     ) FREEX(sposs     [i]);
-		if (sflist    ) FREEX(sflist    [i]);
 		if (sflistlen ) FREEX(sflistlen [i]);
 		if (sentryfl  ) FREEX(sentryfl  [i]);
+		if (sreason   ) FREEX(sreason   [i]);
+		if (sconf     ) FREEX(sconf     [i]);
+		if (sfocus    ) FREEX(sfocus    [i]);
 	}
 	FREEX(sposs);
 	FREEX(spossp);
-	FREEX(sflist);
 	FREEX(sflistlen);
 	FREEX(sentryfl);
 	FREEX(sentry);
+	FREEX(sword);
+	if (swcand) for(i = 0;i <= ne;i++) FREEX(swcand[i]);
+	FREEX(swcand);
+	FREEX(swcandn);
+	FREEX(swcandcap);
+	FREEX(cbuf);
+	cbufcap = 0;
+	FREEX(sactrail);
+	FREEX(sacrs);
+	FREEX(cpar);
+	FREEX(ccomp);
+	FREEX(csize);
+	FREEX(sfocus);
+	cmask = NULL;
+	FREEX(sreason);
+	FREEX(sconf);
+	FREEX(reason);
+	FREEX(rconf);
+	FREEX(ngs);
+	FREEX(nghash);
+	FREEX(ngwatch);
+	FREEX(sbest);
+	FREEX(prfl);
+	FREEX(ewoff);
+	FREEX(ewlist);
+	FREEX(entq);
+	FREEX(wdq);
+	FREEX(wtouch);
+	FREEX(wtouched);
+	for(i = 0;i<nwsup;i++) {
+		if (wsup ) FREEX(wsup [i]);
+		if (wlost) FREEX(wlost[i]);
+	}
+	nwsup = 0;
+	FREEX(wsup);
+	FREEX(wlost);
+	FREEX(wsupok);
+	for(i = 0;i<nfslot;i++) {
+		if (fslot) FREEX(fslot[i]);
+		if (fpos ) FREEX(fpos [i]);
+	}
+	nfslot = 0;
+	FREEX(fslot);
+	FREEX(fpos);
+	FREEX(uwoff);
+	FREEX(uwlist);
+	FREEX(awoff);
+	FREEX(awlist);
+	FREEX(adw);
+	FREEX(adadj);
+	FREEX(adn);
+	FREEX(adwmate);
+	FREEX(adreach);
+	FREEX(adin);
+	FREEX(admate);
+	FREEX(adstamp);
+	FREEX(advis);
+	FREEX(advl);
+	FREEX(adrs);
+	adgen = advgen = 0;
+	nentq = nwdq = 0;
 }
 
-static int allocstack() {int i;
+static int allocstack() {int i,j,n;
 	freestack();
 	if (!(sposs     =calloc(ne+1,sizeof(char*         )))) return 1;
 	if (!(spossp    =calloc(ne+1,sizeof(int           )))) return 1;
-	if (!(sflist    =calloc(ne+1,sizeof(int**         )))) return 1;
 	if (!(sflistlen =calloc(ne+1,sizeof(int*          )))) return 1;
 	if (!(sentryfl  =calloc(ne+1,sizeof(ABM*          )))) return 1;
 	if (!(sentry    =calloc(ne+1,sizeof(int           )))) return 1;
+	if (!(sword     =calloc(ne+1,sizeof(int           )))) return 1;
+	if (!(swcand    =calloc(ne+1,sizeof(int*          )))) return 1;
+	if (!(swcandn   =calloc(ne+1,sizeof(int           )))) return 1;
+	if (!(swcandcap =calloc(ne+1,sizeof(int           )))) return 1;
+	if (!(sreason   =calloc(ne+1,sizeof(unsigned long long*)))) return 1;
+	if (!(sconf     =calloc(ne+1,sizeof(unsigned long long*)))) return 1;
+	nrw = (ne+1+63)/64;
+	if (!(reason    =calloc((ne+nw)*nrw,sizeof(unsigned long long)))) return 1;
+	if (!(rconf     =calloc(nrw,sizeof(unsigned long long)))) return 1;
+	if (!(sacrs     =calloc(nrw,sizeof(unsigned long long)))) return 1;
+	if (!(sactrail  =malloc((nw+1)*sizeof(int         )))) return 1;
+	if (!(cpar      =malloc((ne+1)*sizeof(int         )))) return 1;
+	if (!(ccomp     =malloc((ne+1)*sizeof(int         )))) return 1;
+	if (!(csize     =malloc((ne+1)*sizeof(int         )))) return 1;
+	if (!(sfocus    =calloc(ne+1,sizeof(unsigned char*)))) return 1;
+	if (filler_nogoods) {
+		if (!(ngs       =malloc(NGMAX*sizeof(struct nogood)))) return 1;
+		if (!(nghash    =malloc(NGHASH*sizeof(int         )))) return 1;
+		if (!(ngwatch   =malloc((ne+1)*sizeof(int         )))) return 1;
+		ng_reset();
+	}
+	if (!(sbest     =malloc((ne+1)*sizeof(ABM         )))) return 1;
+	nbest = -1;
+	bestdep = -1;
+	if (!(prfl      =malloc((ne+1)*sizeof(ABM         )))) return 1;
 	for(i = 0;i <= ne;i++) { // for each stack depth that can be reached
 		if (!(sposs     [i] = malloc(NL+1                    ))) return 1;
-		if (!(sflist    [i] = malloc(nw*sizeof(int*         )))) return 1;
 		if (!(sflistlen [i] = malloc(nw*sizeof(int          )))) return 1;
 		if (!(sentryfl  [i] = malloc(ne*sizeof(ABM          )))) return 1;
+		if (!(sreason   [i] = malloc((ne+nw)*nrw*sizeof(unsigned long long)))) return 1;
+		if (!(sconf     [i] = malloc(nrw*sizeof(unsigned long long)))) return 1;
+		if (!(sfocus    [i] = malloc(ne+1                    ))) return 1;
 	}
+	for(i = 0,n = 0;i<nw;i++) n += words[i].nent;
+	if (!(ewoff     =calloc(ne+1,sizeof(int           )))) return 1;
+	if (!(ewlist    =malloc((n+1)*sizeof(int          )))) return 1;
+	if (!(entq      =malloc((ne+1)*sizeof(int         )))) return 1;
+	if (!(wdq       =malloc((nw+1)*sizeof(int         )))) return 1;
+	if (!(wtouch    =malloc((nw+1)*sizeof(int         )))) return 1;
+	if (!(wtouched  =calloc(nw+1,sizeof(unsigned char )))) return 1;
+	if (!(wsup      =calloc(nw+1,sizeof(int*          )))) return 1;
+	if (!(wlost     =calloc(nw+1,sizeof(ABM*          )))) return 1;
+	nwsup = nw;
+	if (!(wsupok    =calloc(nw+1,sizeof(unsigned char )))) return 1;
+	for(i = 0;i<nw;i++) if (!words[i].fe) { // fully entered words never constrain their entries
+		if (!(wsup [i] = malloc(words[i].nent*NL*sizeof(int)))) return 1;
+		if (!(wlost[i] = calloc(words[i].nent,sizeof(ABM   )))) return 1;
+	}
+	// build entry-to-word index so that propagation only visits affected words
+	for(i = 0;i<nw;i++) for(j = 0;j<words[i].nent;j++) ewoff[words[i].e[j]-entries]++;
+	for(i = 1;i <= ne;i++) ewoff[i] += ewoff[i-1];
+	for(i = nw-1;i >= 0;i--) for(j = 0;j<words[i].nent;j++) ewlist[--ewoff[words[i].e[j]-entries]] = i;
 	return 0;
 }
 
@@ -446,8 +1283,10 @@ static void state_init(void) {
 static void state_push(void) {int i;
 	sdep++;
 	assert(sdep <= ne);
+	if (sdep > (int)filler_stats.maxdepth) filler_stats.maxdepth = sdep;
 	for(i = 0;i<nw;i++) sflistlen[sdep][i] = -1;  // flag that flists need allocating
 	for(i = 0;i<ne;i++) sentryfl[sdep][i] = entries[i].flbm; // feasible letter lists
+	memcpy(sreason[sdep],reason,(ne+nw)*nrw*sizeof(unsigned long long));
 }
 
 // undo effect of last deepening operation
@@ -464,13 +1303,13 @@ static void state_restore(void) {int i,j,l; struct word*w;
 			for(j = 0;j<l;j++) setused(w->flist[j],0);
 			w->commitdep = -1;
 		}
-		if (sflistlen[sdep][i] !=  -1&&w->flist !=  0) { // word feasible list to free?
-			free(w->flist);
-			w->flist = sflist[sdep][i];
+		if (sflistlen[sdep][i] !=  -1) { // word feasible list to restore?
+			if (wsup[i]) restore_support(w,sflistlen[sdep][i]);
 			w->flistlen = sflistlen[sdep][i];
 		}
 	}
 	for(i = 0;i<ne;i++) entries[i].flbm = sentryfl[sdep][i];
+	memcpy(reason,sreason[sdep],(ne+nw)*nrw*sizeof(unsigned long long));
 }
 
 // pop stack
@@ -480,6 +1319,36 @@ static void state_pop(void) {
 	sdep--;
 }
 
+// push stack for a lookahead probe; sac_pop() then only visits the words it touches
+static void sac_push(void) {int i;
+	sdep++;
+	assert(sdep <= ne);
+	memset(sflistlen[sdep],0xff,nw*sizeof(int));
+	for(i = 0;i<ne;i++) sentryfl[sdep][i] = entries[i].flbm;
+	memcpy(sreason[sdep],reason,(ne+nw)*nrw*sizeof(unsigned long long));
+	nsactrail = 0;
+	sacing = 1;
+}
+
+// undo a lookahead probe
+static void sac_pop(void) {int i,j,k,l; struct word*w;
+	for(k = 0;k<nsactrail;k++) {
+		i = sactrail[k];
+		w = words+i;
+		if (w->commitdep >= sdep) {
+			l = w->flistlen;
+			for(j = 0;j<l;j++) setused(w->flist[j],0);
+			w->commitdep = -1;
+		}
+		if (wsup[i]) restore_support(w,sflistlen[sdep][i]);
+		w->flistlen = sflistlen[sdep][i];
+	}
+	for(i = 0;i<ne;i++) entries[i].flbm = sentryfl[sdep][i];
+	memcpy(reason,sreason[sdep],(ne+nw)*nrw*sizeof(unsigned long long));
+	sacing = 0;
+	sdep--;
+}
+
 // clear state stacks and free allocated memory
 static void state_finit(void) {
 	while(sdep >= 0)
@@ -487,6 +1356,55 @@ static void state_finit(void) {
 	freestack();
 }
 
+// index the candidates of every list by string and by answer for drop_used()
+// returns 1 if out of memory
+static int buildused(void) {int i,j,l,n,na;
+	na = atotal+NMSG;
+	if (!(fslot =calloc(nw,sizeof(int*)))) return 1;
+	if (!(fpos  =calloc(nw,sizeof(int*)))) return 1;
+	nfslot = nw;
+	if (!(uwoff =calloc(ultotal+1,sizeof(int)))) return 1;
+	if (!(awoff =calloc(na+1,sizeof(int)))) return 1;
+	for(i = 0,n = 0;i<nw;i++) {
+		l = words[i].flistlen;
+		if (!(fslot[i] = malloc((l+1)*sizeof(int)))) return 1;
+		if (!(fpos [i] = malloc((l+1)*sizeof(int)))) return 1;
+		for(j = 0;j<l;j++) {
+			fslot[i][j] = fpos[i][j] = j;
+			uwoff[lts[words[i].flist[j]].uniq+1]++;
+			awoff[lts[words[i].flist[j]].ans+NMSG+1]++;
+		}
+		n += l;
+	}
+	if (!(uwlist=malloc((2*n+1)*sizeof(int)))) return 1;
+	if (!(awlist=malloc((2*n+1)*sizeof(int)))) return 1;
+	filler_stats.list_bytes += (6*n+ultotal+na+2)*sizeof(int);
+	for(i = 0;i<ultotal;i++) uwoff[i+1] += uwoff[i];
+	for(i = 0;i<na;i++) awoff[i+1] += awoff[i];
+	for(i = 0;i<nw;i++) for(j = 0;j<words[i].flistlen;j++) { // fill, advancing each start by one
+		l = words[i].flist[j];
+		n = uwoff[lts[l].uniq]++; uwlist[2*n] = i; uwlist[2*n+1] = j;
+		n = awoff[lts[l].ans+NMSG]++; awlist[2*n] = i; awlist[2*n+1] = j;
+	}
+	for(i = ultotal;i>0;i--) uwoff[i] = uwoff[i-1]; // then put the starts back
+	uwoff[0] = 0;
+	for(i = na;i>0;i--) awoff[i] = awoff[i-1];
+	awoff[0] = 0;
+	if (!filler_alldiff) return 0;
+	if (!(adw    =malloc((nw+1)*sizeof(int)))) return 1;
+	if (!(adadj  =malloc((nw+1)*ADMAX*sizeof(int)))) return 1;
+	if (!(adn    =malloc((nw+1)*sizeof(int)))) return 1;
+	if (!(adwmate=malloc((nw+1)*sizeof(int)))) return 1;
+	if (!(adreach=malloc(nw+1))) return 1;
+	if (!(adin   =calloc(nw+1,1))) return 1;
+	if (!(admate =malloc((ultotal+1)*sizeof(int)))) return 1;
+	if (!(adstamp=calloc(ultotal+1,sizeof(unsigned int)))) return 1;
+	if (!(advis  =calloc(ultotal+1,sizeof(unsigned int)))) return 1;
+	if (!(advl   =malloc(((nw+1)*ADMAX+1)*sizeof(int)))) return 1;
+	if (!(adrs   =calloc(nrw,sizeof(unsigned long long)))) return 1;
+	return 0;
+}
+
 // build initial feasible lists, calling plug-in as necessary
 static int buildlists(void) {int u,i,j;
 	for(i = 0;i<nw;i++) {
@@ -499,70 +1417,745 @@ static int buildlists(void) {int u,i,j;
 			checking[j] = words[i].e[j]->checking;
 		}
 		u = getinitflist(&words[i].flist,&words[i].flistlen,words[i].lp,words[i].wlen);
+		if (u == -5) {postgetinitflist();filler_status = -5;return 1;}
 		if (u) {filler_status = -3;return 0;}
 		if (words[i].lp->ten) clueorderindex++;
 	}
 	if (postgetinitflist()) {filler_status = -4;return 1;}
 	FREEX(aused);
 	FREEX(lused);
-	aused = (unsigned char*)calloc(atotal+NMSG,sizeof(unsigned char)); // enough for "msgword" answers too
+	aused = (int*)calloc(atotal+NMSG,sizeof(int)); // enough for "msgword" answers too
 	if (aused == NULL) {filler_status = -3;return 0;}
-	lused = (unsigned char*)calloc(ultotal,sizeof(unsigned char));
+	lused = (int*)calloc(ultotal,sizeof(int));
 	if (lused == NULL) {filler_status = -3;return 0;}
+	FREEX(uqstamp);
+	uqstamp = (int*)calloc(ultotal,sizeof(int));
+	if (uqstamp == NULL) {filler_status = -3;return 0;}
+	uqgen = 0;
+	for(i = 0,j = 0;i<nw;i++) j += words[i].flistlen;
+	filler_stats.list_bytes = j*sizeof(int);
+	if (afunique&&buildused()) {filler_status = -3;return 1;}
 	return 0;
 }
 
-// Main search routine. Returns
-// -5: told to abort
-// -1: out of memory
-// -2: out of stack
-//  1: all done, no result found
-//  2: all done, result found or only doing BG fill anyway
-static int search() {
-	int e,f;
-	char c;
+static void donate(void);
 
-	// Initially entry flbms are not consistent with word lists or vice versa. So we
-	// need to make sure we call both settlewds() and settleents() before proceeding.
-	settlewds();
+/*
+ * mkscores() skips candidates that are already used, so getposs() can
+ * leave out letters still in an entry's bitmap without any propagation
+ * having removed them.  Put what that depends on into the level's
+ * conflict set: the reasons for the lists of the words through the
+ * entry, and for the words using their remaining candidates.
+ */
+static void omitreasons(int e)
+{
+	int i, j, l;
+	struct word *w;
+	unsigned long long *c;
+
+	c = sconf[sdep];
+	for (i = ewoff[e]; i < ewoff[e + 1]; i++) {
+		w = words + ewlist[i];
+		rs_or(c, WORDRS(ewlist[i]));
+		for (j = 0; j < w->flistlen; j++) {
+			l = w->flist[j];
+			if (lused[lts[l].uniq])
+				rs_or(c, WORDRS(lused[lts[l].uniq] - 1));
+			if (aused[lts[l].ans+NMSG])
+				rs_or(c, WORDRS(aused[lts[l].ans+NMSG] - 1));
+		}
+	}
+}
 
-resettle: // "unit propagation"
-	do {
-		f = settleents(); // rescan entries
-		if (f == 0) break;
-		if (f == -1) return -1; // out of memory: abort
-		if (f == -2) goto backtrack; // proved impossible
-		f = settlewds(); // rescan words
-	} while(f); // need to iterate until everything settles down
-	f = mkscores();
-	if (fillmode == 0||fillmode == 3) return 2; // only doing BG/preexport fill? stop after first settle
-	DEB16 pstate(1);
+/*
+ * Choose a word to branch on instead of entry e, or return -1 to try
+ * e's letters.  The word is the uncommitted one with the shortest live
+ * list; in hybrid mode it must also offer no more candidates than e
+ * has letters.
+ */
+static int pickword(int e)
+{
+	struct word *w;
+	int i, j, b, u;
 
-	// go one level deeper in search tree
-	DEB1 { int w; for(w = 0;w<nw;w++) printf("[w%d: %d]",w,words[w].flistlen); printf("\n"); }
-	e = findcritent(); // find the most critical entry, over whose possible letters we will iterate
-	if (e == -1) return 2; // all done, result found
-	getposs(entries+e,sposs[sdep],afrandom,1); // find feasible letter list in descending order of score
-	DEB1{printf("D%3d ",sdep);sdepsp();printf("E%d %s\n",e,sposs[sdep]);fflush(stdout);}
-	sentry[sdep] = e;
+	b = -1;
+	for (i = 0; i < nw; i++) {
+		w = words + i;
+		if (w->fe || w->commitdep >= 0)
+			continue;
+		for (j = 0, u = 0; j < w->nent; j++) {
+			if (onebit(w->e[j]->flbm))
+				continue;
+			if (fillmode == 2 && w->e[j]->sel == 0)
+				break; // would fix entries outside the selection
+			if (cmask && !cmask[w->e[j] - entries])
+				break; // another component
+			u++;
+		}
+		if (j < w->nent || u == 0)
+			continue;
+		if (b < 0 || w->flistlen < words[b].flistlen)
+			b = i;
+	}
+	if (b >= 0 && filler_branch == 2 && words[b].flistlen > __builtin_popcountll(entries[e].flbm))
+		return -1;
+	return b;
+}
+
+static int cmpcands(const void *p, const void *q)
+{
+	const struct cand *a = p, *b = q;
+
+	if (a->f < b->f) return 1;
+	if (a->f > b->f) return -1;
+	return a->l - b->l;
+}
+
+/*
+ * Collect word wi's live candidates into swcand[sdep], best first, one
+ * per distinct string and skipping those already used, then shuffle
+ * them locally to randomisation level r as getposs() does.  A
+ * candidate's score is the product of the mkscores() scores of its
+ * letters in their entries, so it ranks as its letters would.  Sets
+ * the level's conflict set to the reasons behind the list and behind
+ * the candidates skipped as used.
+ */
+static int getcands(int wi, int r)
+{
+	struct word *w;
+	struct cand *c;
+	const char *t;
+	int i, j, l, m, n, *p;
+
+	w = words + wi;
+	if (swcandcap[sdep] < w->flistlen) {
+		p = realloc(swcand[sdep], w->flistlen * sizeof(int));
+		if (!p)
+			return -1;
+		swcand[sdep] = p;
+		swcandcap[sdep] = w->flistlen;
+	}
+	if (cbufcap < w->flistlen) {
+		c = realloc(cbuf, w->flistlen * sizeof(struct cand));
+		if (!c)
+			return -1;
+		cbuf = c;
+		cbufcap = w->flistlen;
+	}
+	memcpy(sconf[sdep], WORDRS(wi), nrw * sizeof(unsigned long long));
+	for (i = 0, n = 0; i < w->flistlen; i++) {
+		l = w->flist[i];
+		if (afunique && isused(l)) {
+			if (lused[lts[l].uniq])
+				rs_or(sconf[sdep], WORDRS(lused[lts[l].uniq] - 1));
+			if (aused[lts[l].ans+NMSG])
+				rs_or(sconf[sdep], WORDRS(aused[lts[l].ans+NMSG] - 1));
+			continue;
+		}
+		t = lts[l].s;
+		cbuf[n].l = l;
+		cbuf[n].f = 1.0;
+		for (j = 0; j < w->nent; j++)
+			cbuf[n].f *= w->e[j]->score[chartol[(int)t[j]]];
+		n++;
+	}
+	qsort(cbuf, n, sizeof(struct cand), cmpcands);
+	p = swcand[sdep];
+	uqgen++;
+	for (i = 0, j = 0; i < n; i++) {
+		l = cbuf[i].l;
+		if (uqstamp[lts[l].uniq] == uqgen)
+			continue;
+		uqstamp[lts[l].uniq] = uqgen;
+		p[j++] = l;
+	}
+	swcandn[sdep] = n = j;
+	if (r)
+		for (i = 0; i < n; i++) {
+			m = i + rng_below(&frng, r * 2 + 1);
+			if (m >= 0 && m < n)
+				l = p[i], p[i] = p[m], p[m] = l;
+		}
+	return 0;
+}
+
+/* fix the entries of word wi to the letters of string t, by the decision at level d */
+static void setword(int wi, const char *t, int d)
+{
+	struct word *w;
+	struct entry *e;
+	int j;
+
+	w = words + wi;
+	for (j = 0; j < w->nent; j++) {
+		e = w->e[j];
+		if (e->flbm == chartoabm[(int)t[j]])
+			continue;
+		e->flbm = chartoabm[(int)t[j]];
+		memset(ENTRS(e - entries), 0, nrw * sizeof(unsigned long long));
+		ENTRS(e - entries)[d / 64] = 1ULL << (d % 64);
+		mark_entry(e);
+	}
+}
+
+static bool budget_set(void)
+{
+	return filler_timeout > 0 || filler_maxnodes > 0;
+}
+
+/* start the clock for --timeout */
+static void budget_start(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += (time_t)filler_timeout;
+	deadline.tv_nsec += (long)((filler_timeout - (time_t)filler_timeout) * 1e9);
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	npoll = 0;
+}
+
+/*
+ * Has the search used up its budget?  The clock is only read every 256
+ * calls.  A cancellation (abort_flag, set by SIGINT or SIGTERM) counts as
+ * running out, so that it unwinds the same way, parallel workers included.
+ */
+static bool budget_out(void)
+{
+	struct timespec t;
+
+	if (abort_flag)
+		return true;
+	if (filler_maxnodes > 0 && filler_stats.nodes >= filler_maxnodes)
+		return true;
+	if (filler_timeout <= 0 || (++npoll & 255))
+		return false;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec > deadline.tv_sec || (t.tv_sec == deadline.tv_sec && t.tv_nsec >= deadline.tv_nsec);
+}
+
+/* copy the search state for the reporter thread; called by search() between nodes */
+static void progress_snap(void)
+{
+	int i;
+
+	pthread_mutex_lock(&prlock);
+	for (i = 0; i < ne; i++)
+		prfl[i] = entries[i].flbm;
+	prdep = sdep;
+	prnodes = filler_stats.nodes;
+	prwant = 0;
+	pthread_cond_signal(&prcond);
+	pthread_mutex_unlock(&prlock);
+}
+
+/* reporter thread: wait for SIGUSR1 or the next period, then print a snapshot */
+static void *reporter(void *arg)
+{
+	struct timespec p;
+	sigset_t ss;
+	unsigned long long t0, t, n0;
+	int r;
+
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGUSR1);
+	p.tv_sec = (time_t)filler_progress;
+	p.tv_nsec = (long)((filler_progress - p.tv_sec) * 1e9);
+	t0 = now_ns();
+	n0 = 0;
+	for (;;) {
+		r = filler_progress > 0 ? sigtimedwait(&ss, NULL, &p) : sigwaitinfo(&ss, NULL);
+		if (r < 0 && errno == EINTR)
+			continue;
+		pthread_mutex_lock(&prlock);
+		if (prstate != 1)
+			break;
+		prwant = 1;
+		while (prwant && prstate == 1)
+			pthread_cond_wait(&prcond, &prlock);
+		if (prstate != 1)
+			break;
+		t = now_ns();
+		// search() only takes the lock when prwant is set, so it is not held up while this prints
+		report_progress(prfl, prdep, prnodes, (prnodes - n0) * 1e9 / MX(t - t0, 1));
+		t0 = t;
+		n0 = prnodes;
+		pthread_mutex_unlock(&prlock);
+	}
+	pthread_mutex_unlock(&prlock);
+	return NULL;
+}
+
+/*
+ * SIGUSR1 is blocked before the reporter starts, and so in the reporter,
+ * which takes it with sigwait.  It stays blocked afterwards, and in the
+ * forked workers of a parallel search, which have no reporter, so that
+ * the signal is left pending rather than killing the process.
+ */
+static void progress_block(void)
+{
+	sigset_t ss;
+
+	sigemptyset(&ss);
+	sigaddset(&ss, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &ss, NULL);
+}
+
+static void progress_start(void)
+{
+	progress_block();
+	prwant = 0;
+	prstate = 1;
+	if (pthread_create(&prthread, NULL, reporter, NULL))
+		prstate = 0; // no progress reports, but the search can go on
+}
+
+static void progress_stop(void)
+{
+	if (!prstate)
+		return;
+	pthread_mutex_lock(&prlock);
+	prstate = 2;
+	pthread_cond_signal(&prcond);
+	pthread_mutex_unlock(&prlock);
+	pthread_kill(prthread, SIGUSR1); // wake it if it is waiting for the signal
+	pthread_join(prthread, NULL);
+	prstate = 0;
+	prwant = 0;
+}
+
+/* remember the current state if it fixes more entries than any seen so far */
+static void note_best(void)
+{
+	int i, n;
+
+	for (i = 0, n = 0; i < ne; i++)
+		n += onebit(entries[i].flbm);
+	if (n <= nbest)
+		return;
+	nbest = n;
+	for (i = 0; i < ne; i++)
+		sbest[i] = entries[i].flbm;
+}
+
+/* add h to the set of fills seen; returns 1 if new, 0 if already there, -1 if out of memory */
+static int fhash_add(unsigned long long h)
+{
+	unsigned long long *p;
+	int i, n;
+
+	h |= 1;
+	if (2 * (nfhash + 1) > fhashcap) {
+		n = fhashcap ? fhashcap * 2 : 1024;
+		p = calloc(n, sizeof(*p));
+		if (!p)
+			return -1;
+		for (i = 0; i < fhashcap; i++)
+			if (fhash[i]) {
+				int j = fhash[i] & (n - 1);
+				while (p[j])
+					j = (j + 1) & (n - 1);
+				p[j] = fhash[i];
+			}
+		free(fhash);
+		fhash = p;
+		fhashcap = n;
+	}
+	for (i = h & (fhashcap - 1); fhash[i]; i = (i + 1) & (fhashcap - 1))
+		if (fhash[i] == h)
+			return 0;
+	fhash[i] = h;
+	nfhash++;
+	return 1;
+}
+
+/*
+ * Report the fill in entries[] unless an earlier one used the same
+ * words.  The fill is identified by the sum of hashes of its words'
+ * strings, which does not depend on where the words are.  Returns -1
+ * if out of memory.
+ */
+static int newfill(void)
+{
+	unsigned long long h, t;
+	int i, j;
+	char c;
+
+	for (i = 0, h = 0; i < nw; i++) {
+		t = 0xcbf29ce484222325ULL; // FNV-1a
+		for (j = 0; j < words[i].nent; j++) {
+			c = abmtoechar(words[i].e[j]->flbm);
+			t = (t ^ (unsigned char)c) * 0x100000001b3ULL;
+		}
+		h += t;
+	}
+	switch (fhash_add(h)) {
+	case -1:
+		return -1;
+	case 0:
+		filler_stats.dupfills++;
+		return 0;
+	}
+	filler_stats.fills++;
+	report_fill(filler_stats.fills);
+	return 0;
+}
+
+/*
+ * Propagate queued changes to a fixpoint.  Returns -1 if out of
+ * memory, -2 if infeasible (rconf says why), -6 if the fill was
+ * cancelled before the fixpoint was reached, otherwise 0.
+ */
+static int settle(void)
+{
+	int f;
+
+	do {
+		if (abort_flag) {
+			flush_queues();
+			return -6;
+		}
+		f = settleents(); // rescan entries
+		if (f <= 0)
+			return f;
+		f = settlewds(); // rescan words
+		if (f == 0 && ngs)
+			f = ng_propagate(); // then apply what earlier failures taught us
+		if (f == 0 && adw) // then what no two words may share
+			while ((f = alldiff()) > 0 && (f = settlewds()) == 0)
+				;
+		if (f == -2 || f == -6)
+			flush_queues();
+	} while (f > 0);
+	return f;
+}
+
+/*
+ * Singleton arc consistency at entry e: fix each of its letters in
+ * turn, propagate, and remove the letters that fail.  A removal
+ * depends on whatever its probe failed on other than the probe, which
+ * stands in for a decision at this level.  Returns -1 if out of
+ * memory, -2 if every letter failed (rconf says why), -6 if the fill
+ * was cancelled, otherwise the number of letters removed.
+ */
+static int sac(int e)
+{
+	unsigned long long t0, *er;
+	ABM m, b, gone;
+	int d, f, n;
+
+	t0 = now_ns();
+	d = sdep;
+	gone = 0;
+	memset(sacrs, 0, nrw * sizeof(*sacrs));
+	for (m = entries[e].flbm, f = 0; m && d < ne; m &= m - 1) {
+		if (abort_flag) {
+			f = -6;
+			break;
+		}
+		b = m & -m;
+		sac_push();
+		filler_stats.sac_probes++;
+		mark_entry(entries + e);
+		entries[e].flbm = b;
+		er = ENTRS(e);
+		memset(er, 0, nrw * sizeof(*er));
+		er[d / 64] = 1ULL << (d % 64);
+		f = settle();
+		sac_pop();
+		if (f == -1 || f == -6)
+			break;
+		if (f == 0)
+			continue;
+		f = 0;
+		gone |= b;
+		rconf[d / 64] &= ~(1ULL << (d % 64));
+		rs_or(sacrs, rconf);
+	}
+	n = 0;
+	if (f == 0 && gone) {
+		for (m = gone; m; m &= m - 1)
+			n++;
+		filler_stats.sac_removed += n;
+		entries[e].flbm &= ~gone;
+		rs_or(ENTRS(e), sacrs);
+		if (entries[e].flbm) {
+			mark_entry(entries + e);
+		} else {
+			memcpy(rconf, ENTRS(e), nrw * sizeof(*rconf));
+			filler_stats.sac_wipeouts++;
+			f = -2;
+		}
+	}
+	filler_stats.sac_ns += now_ns() - t0;
+	return f ? f : n;
+}
+
+static int cfind(int i)
+{
+	while (cpar[i] != i)
+		i = cpar[i] = cpar[cpar[i]];
+	return i;
+}
+
+/*
+ * Label the entries still to be filled by connected component, two
+ * entries being connected if a word contains both.  Returns the number
+ * of components.
+ */
+static int components(void)
+{
+	struct word *w;
+	int i, j, k, x, n;
+
+	for (i = 0; i < ne; i++)
+		cpar[i] = (onebit(entries[i].flbm) || (fillmode == 2 && entries[i].sel == 0)) ? -1 : i;
+	for (i = 0; i < nw; i++) {
+		w = words + i;
+		for (j = 0, k = -1; j < w->nent; j++) {
+			x = w->e[j] - entries;
+			if (cpar[x] < 0)
+				continue;
+			if (k < 0)
+				k = cfind(x);
+			else if ((x = cfind(x)) != k)
+				cpar[x] = k;
+		}
+	}
+	for (i = 0, n = 0; i < ne; i++)
+		if (cpar[i] == i)
+			csize[n] = 0, ccomp[i] = n++;
+	for (i = 0; i < ne; i++)
+		if (cpar[i] >= 0) {
+			ccomp[i] = ccomp[cfind(i)];
+			csize[ccomp[i]]++;
+		} else
+			ccomp[i] = -1;
+	return n;
+}
+
+/*
+ * Find the entry to expand next as findcritent() does, but from the
+ * component the level above was filling while any of it is left.
+ * The component of the entry found becomes this level's.
+ */
+static int focuscritent(void)
+{
+	unsigned char *f;
+	int e, i, n;
+
+	n = components();
+	if (n > 1) {
+		filler_stats.splits++;
+		filler_stats.comps += n;
+	}
+	cmask = NULL;
+	if (sdep > 0) {
+		f = sfocus[sdep - 1];
+		for (i = 0; i < ne; i++)
+			if (f[i] && ccomp[i] >= 0)
+				break;
+		if (i < ne)
+			cmask = f;
+	}
+	e = findcritent();
+	cmask = sfocus[sdep];
+	for (i = 0; i < ne; i++)
+		cmask[i] = e >= 0 && ccomp[i] == ccomp[e];
+	return e;
+}
+
+/* i-th term (from 1) of the Luby sequence */
+static unsigned long long luby(unsigned long long i)
+{
+	int k;
+
+	for (k = 1; (1ULL << k) - 1 < i; k++)
+		;
+	if (i == (1ULL << k) - 1)
+		return 1ULL << (k - 1);
+	return luby(i - (1ULL << (k - 1)) + 1);
+}
+
+/* backtracks allowed in attempt n (from 0), or 0 for no limit */
+static unsigned long long rslimit(int n)
+{
+	if (filler_restart <= 0 || wsh || filler_nfills) // a stolen job cannot start again from the root; enumeration would repeat itself
+		return 0;
+	if (filler_rgrowth > 1)
+		return filler_restart * pow(filler_rgrowth, n);
+	return filler_restart * luby(n + 1);
+}
+
+/* note the nodes searched by an attempt just finished */
+static void rsnote(unsigned long long n)
+{
+	unsigned long long *p;
+
+	if (nrsnodes == rsnodescap) {
+		p = realloc(rsnodes, (rsnodescap * 2 + 16) * sizeof(*p));
+		if (!p)
+			return;
+		rsnodes = p;
+		rsnodescap = rsnodescap * 2 + 16;
+	}
+	rsnodes[nrsnodes++] = n;
+}
+
+// Main search routine. Returns
+// -6: search budget used up; the best partial fill is in sbest[]
+// -5: told to abort
+// -1: out of memory
+// -2: out of stack
+//  1: all done, no result found
+//  2: all done, result found or only doing BG fill anyway
+static int search() {
+	int e,f,h,att,sacd;
+	ABM l;
+	char c;
+	unsigned long long bt,lim,n0,t;
+
+	sacd = -1; // depth at which the lookahead last ran, so it runs once per node
+	att = 0;
+	bt = 0;
+	lim = rslimit(0);
+	n0 = filler_stats.nodes;
+restart:
+	// Initially entry flbms are not consistent with word lists or vice versa. So we
+	// need to make sure we call both settlewds() and settleents() before proceeding.
+	settlewds();
+	sacd = -1;
+
+resettle: // "unit propagation"
+	t = now_ns();
+	f = settle();
+	filler_stats.prop_ns += now_ns()-t;
+	if (f == -1) return -1; // out of memory: abort
+	if (f == -2) goto backtrack; // proved impossible: rconf says why
+	if (f == -6) {note_best();return -6;} // cancelled part way
+	t = now_ns();
+	f = mkscores();
+	filler_stats.score_ns += now_ns()-t;
+	if (fillmode == 0||fillmode == 3) return 2; // only doing BG/preexport fill? stop after first settle
+	if (budget_set() && sdep >= bestdep) { // only the deepest level reached so far is worth counting entries at
+		bestdep = sdep;
+		note_best();
+	}
+	DEB16 pstate(1);
+
+	// go one level deeper in search tree
+	DEB1 { int w; for(w = 0;w<nw;w++) printf("[w%d: %d]",w,words[w].flistlen); printf("\n"); }
+	t = now_ns();
+	e = filler_decomp?focuscritent():findcritent(); // find the most critical entry, over whose possible letters we will iterate
+	filler_stats.crit_ns += now_ns()-t;
+	if (e == -1) { // all done, result found
+		if (filler_nfills) { // enumerating: report it and carry on from here
+			if (newfill()) return -1;
+			if (filler_stats.fills >= filler_nfills) return 2;
+			memset(rconf,0,nrw*sizeof(unsigned long long)); // never jump over a level that could lead to another fill
+			for(h = 0;h<sdep;h++) rconf[h/64] |= 1ULL<<(h%64);
+			goto unwind;
+		}
+		if (lim) rsnote(filler_stats.nodes-n0);
+		return 2;
+	}
+	if (sdep < filler_sac && sacd != sdep) { // look one letter ahead before branching
+		sacd = sdep;
+		f = sac(e);
+		if (f == -1) return -1;
+		if (f == -6) {note_best();return -6;}
+		if (f == -2) goto backtrack;
+		if (f) goto resettle;
+	}
+	sentry[sdep] = e;
 	spossp[sdep] = 0; // start on most likely possibility
+	sword[sdep] = filler_branch?pickword(e):-1;
+	if (sword[sdep] >= 0) { // try whole words instead
+		if (getcands(sword[sdep],att?MX(afrandom,1):afrandom)) return -1;
+		DEB1{printf("D%3d ",sdep);sdepsp();printf("W%d %d candidates\n",sword[sdep],swcandn[sdep]);fflush(stdout);}
+		goto nextposs;
+	}
+	getposs(entries+e,sposs[sdep],att?MX(afrandom,1):afrandom,1,&frng); // find feasible letter list in descending order of score; vary it after a restart
+	DEB1{printf("D%3d ",sdep);sdepsp();printf("E%d %s\n",e,sposs[sdep]);fflush(stdout);}
+	memcpy(sconf[sdep],ENTRS(e),nrw*sizeof(unsigned long long)); // running out of letters also depends on why the others went
+	for(h = 0,l = 0;sposs[sdep][h];h++) l |= chartoabm[(int)sposs[sdep][h]];
+	if (entries[e].flbm&~l) omitreasons(e); // letters mkscores() found only in used words
 
 	// try one possibility at the current critical entry
 nextposs:
+	if (wsh) {
+		if (wsh->done) return -5; // another worker has finished the search
+		if (wsh->idle > wsh->njob) donate();
+	}
+	if (budget_out()) {
+		if (abort_flag) note_best(); // only tracked at every node when there is a budget
+		return -6;
+	}
+	if (prwant) progress_snap();
+	if (sword[sdep] >= 0) goto nextword;
 	e = sentry[sdep];
-	if (sposs[sdep][spossp[sdep]] == '\0') goto backtrack; // none left: backtrack
+	if (sposs[sdep][spossp[sdep]] == '\0') { // none left: fail for the reasons all the children failed
+		memcpy(rconf,sconf[sdep],nrw*sizeof(unsigned long long));
+		goto backtrack;
+	}
 	c = sposs[sdep][spossp[sdep]++]; // get letter to try
 	DEB1 {  printf("D%3d ",sdep);sdepsp();printf(":%c:\n",c);fflush(stdout); }
 	if (sdep == ne) return -2; // out of stack space (should never happen)
 	state_push();
-	entries[e].upd = 1;
+	sacd = -1;
+	filler_stats.nodes++;
+	mark_entry(entries+e);
 	entries[e].flbm = chartoabm[(int)c]; // fix feasible list
+	memset(ENTRS(e),0,nrw*sizeof(unsigned long long));
+	ENTRS(e)[(sdep-1)/64] = 1ULL<<((sdep-1)%64); // entry now depends only on this decision
 	goto resettle; // update internal data from new entry
 
-backtrack:
-	state_pop();
-	if (sdep !=  -1) goto nextposs;
-	return 1; // all done, no solution found
+	// try one candidate for the word being branched on
+nextword:
+	if (spossp[sdep] == swcandn[sdep]) { // none left
+		memcpy(rconf,sconf[sdep],nrw*sizeof(unsigned long long));
+		goto backtrack;
+	}
+	h = swcand[sdep][spossp[sdep]++];
+	DEB1 {  printf("D%3d ",sdep);sdepsp();printf(":%s:\n",lts[h].s);fflush(stdout); }
+	if (sdep == ne) return -2; // out of stack space (should never happen)
+	state_push();
+	sacd = -1;
+	filler_stats.nodes++;
+	setword(sword[sdep-1],lts[h].s,sdep-1);
+	goto resettle;
+
+backtrack: // jump back to the deepest decision that contributed to the failure
+	if (filler_chrono)
+		for (h = 0; h < sdep; h++)
+			rconf[h / 64] |= 1ULL << (h % 64);
+	if (ngs)
+		ng_learn();
+unwind:
+	filler_stats.backtracks++;
+	if (lim&&++bt>lim&&rs_max(rconf) >= 0) { // attempt over: back to the root, keeping the nogoods learnt
+		while (sdep > 0) state_pop();
+		state_restore();
+		mark_all();
+		rsnote(filler_stats.nodes-n0);
+		filler_stats.restarts++;
+		DEB1 printf("restart %d after %llu backtracks\n",att+1,bt);
+		n0 = filler_stats.nodes;
+		bt = 0;
+		lim = rslimit(++att);
+		goto restart;
+	}
+	h = rs_max(rconf);
+	if (h < sdep-1) filler_stats.backjumps += sdep-1-MX(h,-1);
+	while (sdep > h) state_pop();
+	if (sdep == -1) { // all done, no solution found
+		if (lim) rsnote(filler_stats.nodes-n0);
+		return filler_stats.fills?2:1; // when enumerating, 2 if anything was reported
+	}
+	rconf[h/64] &= ~(1ULL<<(h%64));
+	rs_or(sconf[h],rconf);
+	goto nextposs;
 }
 
 static void searchdone() {
@@ -573,6 +2166,10 @@ static void searchdone() {
 		mkfeas(); // construct feasible word list
 		DEB1 pstate(1);
 	}
+	else if ((filler_status == -6||filler_status == -5)&&nbest >= 0) { // out of time or cancelled: offer the most complete partial fill seen
+		for(i = 0;i<ne;i++) entries[i].flbm = sbest[i];
+		llistp = NULL;llistn = 0;
+	}
 	else {
 		for(i = 0;i<ne;i++) entries[i].flbm = 0; // clear feasible letter bitmaps
 		llistp = NULL;llistn = 0; // no feasible word list
@@ -592,21 +2189,625 @@ static void searchdone() {
 	return;
 }
 
-int filler_search()
+/*
+ * Portfolio search.  Each worker is a forked copy of the solver that
+ * searches the whole tree with its own random seed and, apart from
+ * worker 0, its own randomisation level and entry ordering.  Since
+ * every worker's search is complete, the first one to report either
+ * a fill or that none exists decides the outcome and the others are
+ * killed.
+ */
+struct presult {
+	int status;
+	int nbest;                 // entries fixed in the partial fill following, if status is -6
+	struct filler_stats st;
+};
+
+/* pass a cancellation on to the n workers in pid[], in case the signal only reached this process; returns 1 */
+static int abort_workers(const pid_t *pid, int n)
 {
 	int i;
 
+	for (i = 0; i < n; i++)
+		if (pid[i] > 0)
+			kill(pid[i], SIGTERM);
+	return 1;
+}
+
+static int write_all(int fd, const void *buf, size_t n)
+{
+	const char *p = buf;
+	ssize_t r;
+
+	while (n) {
+		r = write(fd, p, n);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return -1;
+		p += r;
+		n -= r;
+	}
+	return 0;
+}
+
+static int read_all(int fd, void *buf, size_t n)
+{
+	char *p = buf;
+	ssize_t r;
+
+	while (n) {
+		r = read(fd, p, n);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return -1;
+		p += r;
+		n -= r;
+	}
+	return 0;
+}
+
+/* add the counters in s to d */
+static void stats_add(struct filler_stats *d, const struct filler_stats *s)
+{
+	unsigned long long *p = (unsigned long long *)d;
+	const unsigned long long *q = (const unsigned long long *)s;
+	unsigned long long m;
+	size_t i;
+
+	m = MX(d->maxdepth, s->maxdepth);
+	for (i = 0; i < sizeof(*d) / sizeof(*p); i++)
+		p[i] += q[i];
+	d->maxdepth = m;
+}
+
+static void pworker(int i, unsigned long long seed, int fd)
+{
+	struct presult r;
+	int j;
+
+	rng_seed(&frng, seed);
+	if (i > 0) {
+		afrandom = MX(afrandom, 1) + (i - 1) % 3;
+		critmode = i % 2;
+	}
+	r.status = search();
+	r.st = filler_stats;
+	r.nbest = nbest;
+	if (write_all(fd, &r, sizeof(r)))
+		_exit(1);
+	if (r.status == 2)
+		for (j = 0; j < ne; j++)
+			if (write_all(fd, &entries[j].flbm, sizeof(ABM)))
+				_exit(1);
+	if (r.status == -6 && nbest >= 0)
+		if (write_all(fd, sbest, ne * sizeof(ABM)))
+			_exit(1);
+	if (write_all(fd, &nrsnodes, sizeof(int)) ||
+	    write_all(fd, rsnodes, nrsnodes * sizeof(*rsnodes)))
+		_exit(1);
+	_exit(0);
+}
+
+static int portfolio(void)
+{
+	struct presult r;
+	struct pollfd *pfd;
+	pid_t *pid;
+	ABM *part;
+	unsigned long long t;
+	int i, j = 0, n, left, fds[2];
+	int status = -1, budget = 0, ab = 0;
+
+	pid = calloc(filler_jobs, sizeof(pid_t));
+	pfd = calloc(filler_jobs, sizeof(struct pollfd));
+	part = malloc(ne * sizeof(ABM));
+	if (!pid || !pfd || !part)
+		goto done;
+
+	fflush(stdout);
+	for (i = 0; i < filler_jobs; i++) {
+		pfd[i].fd = -1;
+		if (pipe(fds))
+			break;
+		pid[i] = fork();
+		if (pid[i] == 0) {
+			close(fds[0]);
+			pworker(i, rng_next(&frng) + i, fds[1]);
+		}
+		close(fds[1]);
+		if (pid[i] < 0) {
+			close(fds[0]);
+			break;
+		}
+		pfd[i].fd = fds[0];
+		pfd[i].events = POLLIN;
+	}
+	DEB1 printf("portfolio: %d workers started\n", i);
+
+	for (left = i; left > 0 && status < 1; ) {
+		if (abort_flag && !ab)
+			ab = abort_workers(pid, filler_jobs);
+		if (poll(pfd, filler_jobs, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (i = 0; i < filler_jobs && status < 1; i++) {
+			if (pfd[i].fd < 0 || !pfd[i].revents)
+				continue;
+			if (read_all(pfd[i].fd, &r, sizeof(r)))
+				r.status = -1;
+			if (r.status == -6 && r.nbest >= 0) {
+				// out of budget: keep the most complete partial fill while others finish
+				if (!read_all(pfd[i].fd, part, ne * sizeof(ABM)) && r.nbest > nbest) {
+					memcpy(sbest, part, ne * sizeof(ABM));
+					nbest = r.nbest;
+					filler_stats = r.st;
+					budget = 1;
+				}
+			} else if (r.status >= 1) {
+				if (r.status == 2)
+					for (j = 0; j < ne; j++)
+						if (read_all(pfd[i].fd, &entries[j].flbm, sizeof(ABM)))
+							break;
+				if ((r.status == 1 || j == ne) && !read_all(pfd[i].fd, &n, sizeof(int))) {
+					nrsnodes = 0;
+					while (n-- > 0 && !read_all(pfd[i].fd, &t, sizeof(t)))
+						rsnote(t);
+					status = r.status;
+					filler_stats = r.st;
+					DEB1 printf("portfolio: worker %d finished with %d\n", i, status);
+				}
+			}
+			close(pfd[i].fd);
+			pfd[i].fd = -1;
+			left--;
+		}
+	}
+
+done:
+	for (i = 0; i < filler_jobs; i++) {
+		if (!pid || pid[i] <= 0)
+			continue;
+		kill(pid[i], SIGKILL);
+		waitpid(pid[i], NULL, 0);
+		if (pfd[i].fd >= 0)
+			close(pfd[i].fd);
+	}
+	free(pid);
+	free(pfd);
+	free(part);
+	if (status < 1 && budget)
+		status = -6;
+	return status;
+}
+
+/*
+ * Work-stealing search.  The workers are forked copies of the solver
+ * that share a pool of jobs in anonymous shared memory.  A job is the
+ * list of (entry, letter) decisions leading from the root to an
+ * unexplored subtree.  A busy worker that sees more idle workers than
+ * queued jobs gives away the last untried letter at the shallowest
+ * level of its stack with alternatives left, as that is likely to be
+ * the largest piece of work it has.  The search is over when a worker
+ * finds a fill, or when every worker is idle with the pool empty.
+ */
+static int *wjob(int j)
+{
+	return wjobs + j * (2 * ne + 1);
+}
+
+static bool level_open(int d)
+{
+	if (sword[d] >= 0)
+		return spossp[d] < swcandn[d];
+	return sposs[d][spossp[d]] != '\0';
+}
+
+static void donate(void)
+{
+	int d, j, k, n, *p;
+	const char *t;
+	ABM *fl;
+
+	for (d = 0; d <= sdep; d++)
+		if (level_open(d))
+			break;
+	if (d > sdep)
+		return;
+	pthread_mutex_lock(&wsh->lock);
+	if (wsh->idle > wsh->njob && wsh->njob < wsh->cap) {
+		// the job is every entry fixed at level d, plus the alternative given away
+		p = wjob(wsh->njob);
+		fl = d < sdep ? sentryfl[d + 1] : NULL;
+		for (k = 0; k < ne; k++)
+			jfix[k] = onebit(fl ? fl[k] : entries[k].flbm) ? (fl ? fl[k] : entries[k].flbm) : 0;
+		if (sword[d] >= 0) {
+			t = lts[swcand[d][--swcandn[d]]].s;
+			for (j = 0; j < words[sword[d]].nent; j++)
+				jfix[words[sword[d]].e[j] - entries] = chartoabm[(int)t[j]];
+		} else {
+			k = strlen(sposs[d]) - 1;
+			jfix[sentry[d]] = chartoabm[(int)sposs[d][k]];
+			sposs[d][k] = '\0';
+		}
+		for (k = 0, n = 0; k < ne; k++)
+			if (jfix[k]) {
+				p[1 + 2 * n] = k;
+				p[2 + 2 * n++] = __builtin_ctzll(jfix[k]);
+			}
+		for (k = 0; k < d; k++) // the donated child's failures are not seen here
+			sconf[d][k / 64] |= 1ULL << (k % 64);
+		p[0] = n;
+		wsh->njob++;
+		pthread_cond_signal(&wsh->cond);
+		DEB1 printf("donated job at depth %d\n", d);
+	}
+	pthread_mutex_unlock(&wsh->lock);
+}
+
+static void sworker(void)
+{
+	int i, r, *p;
+
+	state_pop(); // each job starts from a fresh push of the root state
+	r = 1;
+	for (;;) {
+		pthread_mutex_lock(&wsh->lock);
+		while (!wsh->done && wsh->njob == 0) {
+			if (wsh->idle == wsh->nworkers - 1) { // no work left anywhere
+				wsh->done = 1;
+				wsh->status = 1;
+				pthread_cond_broadcast(&wsh->cond);
+				break;
+			}
+			wsh->idle++;
+			pthread_cond_wait(&wsh->cond, &wsh->lock);
+			wsh->idle--;
+		}
+		if (wsh->done) {
+			pthread_mutex_unlock(&wsh->lock);
+			break;
+		}
+		p = wjob(--wsh->njob);
+		jlen = p[0];
+		memcpy(jpath, p + 1, 2 * jlen * sizeof(int));
+		pthread_mutex_unlock(&wsh->lock);
+
+		// nogoods learnt in a job hold only under its path, and a level that donated
+		// work records failures it has not seen, so each job starts with none
+		if (ngs)
+			ng_reset();
+		state_push();
+		mark_all();
+		for (i = 0; i < jlen; i++)
+			entries[jpath[2 * i]].flbm = 1ULL << jpath[2 * i + 1];
+		r = search();
+		if (r == 1)
+			continue; // subtree exhausted: look for more work
+		pthread_mutex_lock(&wsh->lock);
+		if (!wsh->done) {
+			wsh->done = 1;
+			wsh->status = r;
+			if (r == 2)
+				for (i = 0; i < ne; i++)
+					wfill[i] = entries[i].flbm;
+			if (r == -6 && nbest >= 0)
+				for (i = 0; i < ne; i++)
+					wfill[i] = sbest[i];
+			wsh->nbest = nbest;
+			pthread_cond_broadcast(&wsh->cond);
+		}
+		pthread_mutex_unlock(&wsh->lock);
+		break;
+	}
+	pthread_mutex_lock(&wsh->lock);
+	stats_add(&wsh->st, &filler_stats);
+	pthread_mutex_unlock(&wsh->lock);
+	_exit(0);
+}
+
+static int steal(void)
+{
+	pthread_mutexattr_t ma;
+	pthread_condattr_t ca;
+	size_t sz;
+	pid_t *pid;
+	void *m;
+	int i, n, r, ws, status, ab = 0;
+
+	n = filler_jobs;
+	sz = sizeof(struct wshared) + 2 * n * (2 * ne + 1) * sizeof(int) + ne * sizeof(ABM);
+	m = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (m == MAP_FAILED)
+		return -1;
+	pid = calloc(n, sizeof(pid_t));
+	jpath = malloc((2 * ne + 1) * sizeof(int));
+	jfix = malloc((ne + 1) * sizeof(ABM));
+	if (!pid || !jpath || !jfix) {
+		status = -1;
+		goto ex0;
+	}
+	wsh = m;
+	memset(wsh, 0, sizeof(*wsh));
+	wfill = (ABM *)(wsh + 1);
+	wjobs = (int *)(wfill + ne);
+	pthread_mutexattr_init(&ma);
+	pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+	pthread_mutex_init(&wsh->lock, &ma);
+	pthread_condattr_init(&ca);
+	pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+	pthread_cond_init(&wsh->cond, &ca);
+	wsh->nworkers = n;
+	wsh->cap = 2 * n;
+	wjob(0)[0] = 0; // the root
+	wsh->njob = 1;
+
+	fflush(stdout);
+	for (i = 0; i < n; i++) {
+		pid[i] = fork();
+		if (pid[i] == 0)
+			sworker();
+		if (pid[i] < 0)
+			break;
+	}
+	if (i < n) { // count workers that never started as idle
+		pthread_mutex_lock(&wsh->lock);
+		wsh->nworkers = i;
+		if (i == 0)
+			wsh->done = 1, wsh->status = -1;
+		pthread_cond_broadcast(&wsh->cond);
+		pthread_mutex_unlock(&wsh->lock);
+	}
+	DEB1 printf("steal: %d workers started\n", i);
+
+	for (i = 0; i < n; i++) {
+		if (pid[i] <= 0)
+			continue;
+		do {
+			if (abort_flag && !ab)
+				ab = abort_workers(pid + i, n - i);
+			r = waitpid(pid[i], &ws, 0);
+		} while (r < 0 && errno == EINTR);
+		if (r < 0 || !WIFEXITED(ws) || WEXITSTATUS(ws)) {
+			pthread_mutex_lock(&wsh->lock); // a worker died: its subtree is lost
+			if (!wsh->done)
+				wsh->done = 1, wsh->status = -1;
+			pthread_cond_broadcast(&wsh->cond);
+			pthread_mutex_unlock(&wsh->lock);
+		}
+	}
+	status = wsh->status;
+	filler_stats = wsh->st;
+	if (status == 2)
+		for (i = 0; i < ne; i++)
+			entries[i].flbm = wfill[i];
+	if (status == -6 && wsh->nbest >= 0) {
+		memcpy(sbest, wfill, ne * sizeof(ABM));
+		nbest = wsh->nbest;
+	}
+	pthread_cond_destroy(&wsh->cond);
+	pthread_mutex_destroy(&wsh->lock);
+	pthread_condattr_destroy(&ca);
+	pthread_mutexattr_destroy(&ma);
+	wsh = NULL;
+
+ex0:
+	free(pid);
+	FREEX(jpath);
+	FREEX(jfix);
+	munmap(m, sz);
+	return status;
+}
+
+/* fill the entries of the components owner[] gives to worker w as a selection */
+static void cworker(int w, const int *owner, int fd)
+{
+	struct presult r;
+	int i;
+
+	for (i = 0; i < ne; i++)
+		entries[i].sel = ccomp[i] >= 0 && owner[ccomp[i]] == w;
+	fillmode = 2;
+	memset(&filler_stats, 0, sizeof(filler_stats)); // the parent has counted the root
+	r.status = search();
+	r.st = filler_stats;
+	r.nbest = nbest;
+	if (write_all(fd, &r, sizeof(r)))
+		_exit(1);
+	if (r.status == 2)
+		for (i = 0; i < ne; i++)
+			if (write_all(fd, &entries[i].flbm, sizeof(ABM)))
+				_exit(1);
+	if (r.status == -6 && nbest >= 0)
+		if (write_all(fd, sbest, ne * sizeof(ABM)))
+			_exit(1);
+	_exit(0);
+}
+
+/*
+ * Parallel decomposition.  If the settled root has come apart into
+ * independent components, share them out between up to filler_jobs
+ * forked workers, largest first to the least loaded, and put the
+ * fills they find together.  Answers shared between components are
+ * the one thing that can still tie them: if the combined fill uses
+ * one twice, the grid is searched again here in one piece.  A grid
+ * still in one piece goes to the usual parallel search.
+ */
+static int decompose(void)
+{
+	struct presult r;
+	struct pollfd *pfd;
+	pid_t *pid;
+	ABM *fill, *part;
+	int *owner, *load;
+	int i, j, k, n, nj, left, fds[2];
+	int status = -1, started = 0, ab = 0;
+
+	i = settle();
+	if (i == -1 || i == -6)
+		return i;
+	if (i == -2)
+		return 1;
+	n = components();
+	cmask = NULL;
+	if (n < 2)
+		return filler_steal ? steal() : portfolio();
+	nj = filler_jobs < n ? filler_jobs : n;
+	pid = calloc(nj, sizeof(pid_t));
+	pfd = calloc(nj, sizeof(struct pollfd));
+	fill = malloc(ne * sizeof(ABM));
+	part = malloc(ne * sizeof(ABM));
+	owner = malloc(n * sizeof(int));
+	load = calloc(nj, sizeof(int));
+	if (!pid || !pfd || !fill || !part || !owner || !load)
+		goto done;
+	for (i = 0; i < n; i++)
+		owner[i] = -1;
+	for (k = 0; k < n; k++) {
+		for (i = 0, j = -1; i < n; i++) // largest component not yet given out
+			if (owner[i] < 0 && (j < 0 || csize[i] > csize[j]))
+				j = i;
+		for (i = 1, owner[j] = 0; i < nj; i++)
+			if (load[i] < load[owner[j]])
+				owner[j] = i;
+		load[owner[j]] += csize[j];
+	}
+	for (i = 0; i < ne; i++)
+		fill[i] = entries[i].flbm;
+	DEB1 printf("decompose: %d components over %d workers\n", n, nj);
+
+	fflush(stdout);
+	for (i = 0; i < nj; i++) {
+		pfd[i].fd = -1;
+		if (pipe(fds))
+			break;
+		pid[i] = fork();
+		if (pid[i] == 0) {
+			close(fds[0]);
+			cworker(i, owner, fds[1]);
+		}
+		close(fds[1]);
+		if (pid[i] < 0) {
+			close(fds[0]);
+			break;
+		}
+		pfd[i].fd = fds[0];
+		pfd[i].events = POLLIN;
+	}
+	started = i;
+	if (started < nj)
+		goto done;
+
+	status = 2;
+	for (left = nj; left > 0 && status != 1 && status != -1; ) {
+		if (abort_flag && !ab)
+			ab = abort_workers(pid, nj);
+		if (poll(pfd, nj, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			status = -1;
+			break;
+		}
+		for (i = 0; i < nj; i++) {
+			if (pfd[i].fd < 0 || !pfd[i].revents)
+				continue;
+			if (read_all(pfd[i].fd, &r, sizeof(r)))
+				r.status = -1;
+			if (r.status == 2 || (r.status == -6 && r.nbest >= 0)) {
+				if (read_all(pfd[i].fd, part, ne * sizeof(ABM)))
+					r.status = -1;
+				else
+					for (j = 0; j < ne; j++)
+						if (ccomp[j] >= 0 && owner[ccomp[j]] == i)
+							fill[j] = part[j];
+			}
+			if (r.status != -1)
+				stats_add(&filler_stats, &r.st);
+			DEB1 printf("decompose: worker %d finished with %d\n", i, r.status);
+			if (r.status == 1)
+				status = 1;
+			else if (r.status == -6 && status == 2)
+				status = -6;
+			else if (r.status != 2 && r.status != -6)
+				status = -1;
+			close(pfd[i].fd);
+			pfd[i].fd = -1;
+			left--;
+		}
+	}
+
+done:
+	for (i = 0; i < started; i++) {
+		kill(pid[i], SIGKILL);
+		waitpid(pid[i], NULL, 0);
+		if (pfd[i].fd >= 0)
+			close(pfd[i].fd);
+	}
+	if (status == 2) { // check the pieces fit together
+		state_push();
+		for (i = 0; i < ne; i++)
+			if (entries[i].flbm != fill[i]) {
+				entries[i].flbm = fill[i];
+				mark_entry(entries + i);
+			}
+		if (settle() != 0 || findcritent() != -1) {
+			DEB1 printf("decompose: components clash, searching the whole grid\n");
+			state_pop();
+			mark_all();
+			status = search();
+		}
+	} else if (status == -6) {
+		memcpy(sbest, fill, ne * sizeof(ABM));
+		for (i = 0, nbest = 0; i < ne; i++)
+			nbest += onebit(fill[i]);
+	} else if (started < nj && status == -1) { // could not start the workers
+		mark_all();
+		status = search();
+	}
+	free(pid);
+	free(pfd);
+	free(fill);
+	free(part);
+	free(owner);
+	free(load);
+	return status;
+}
+
+int filler_search()
+{
+	unsigned long long t0, bns, lb;
+
+	t0 = now_ns();
 	clueorderindex = 0;
 	if (buildlists())
 		goto ex0;
+	bns = now_ns() - t0;
+	lb = filler_stats.list_bytes;
 
 	DEB1 pstate(1);
-	for(i = 0;i<ne;i++)
-		entries[i].upd = 1;
-	for(i = 0;i<nw;i++)
-		words[i].upd = 1;
-
-	filler_status = search();
+	mark_all();
+	t0 = now_ns();
+	if (filler_timeout > 0)
+		budget_start();
+
+	if (filler_jobs > 1 && (fillmode == 1 || fillmode == 2) && !filler_nfills) {
+		progress_block();
+		filler_status = filler_decomp ? decompose() : filler_steal ? steal() : portfolio();
+	}
+	else {
+		if (fillmode == 1 || fillmode == 2)
+			progress_start();
+		filler_status = search();
+		progress_stop();
+	}
+	if (filler_status == -6 && abort_flag)
+		filler_status = -5;
+	filler_stats.search_ns = now_ns() - t0;
+	filler_stats.build_ns = bns; // workers' copies would have counted these again
+	filler_stats.list_bytes = lb;
 	if (fillmode != 3)
 		searchdone(); // tidy up unless in pre-export mode
 
@@ -616,6 +2817,78 @@ ex0:
 }
 
 
+void filler_pstats(FILE*fp)
+{
+	int i;
+
+	fprintf(fp, "nodes: %llu\n", filler_stats.nodes);
+	fprintf(fp, "backtracks: %llu, max depth %llu\n", filler_stats.backtracks, filler_stats.maxdepth);
+	fprintf(fp, "candidates removed: %llu (%llu by letter), lists %llu KB\n",
+		filler_stats.cands_removed, filler_stats.isect_removed, filler_stats.list_bytes / 1024);
+	fprintf(fp, "passes: %llu settleents, %llu settlewds\n", filler_stats.ent_passes, filler_stats.wds_passes);
+	fprintf(fp, "time: %.1f ms building lists, %.1f ms searching: %.1f propagating, %.1f scoring, %.1f choosing\n",
+		filler_stats.build_ns / 1e6, filler_stats.search_ns / 1e6, filler_stats.prop_ns / 1e6,
+		filler_stats.score_ns / 1e6, filler_stats.crit_ns / 1e6);
+	fprintf(fp, "queue pushes: %llu entries, %llu words (%.1f, %.1f per node)\n",
+		filler_stats.entq_pushes, filler_stats.wdq_pushes,
+		(double)filler_stats.entq_pushes / MX(filler_stats.nodes, 1),
+		(double)filler_stats.wdq_pushes / MX(filler_stats.nodes, 1));
+	fprintf(fp, "levels skipped by backjumping: %llu\n", filler_stats.backjumps);
+	if (filler_nogoods)
+		fprintf(fp, "nogoods: %llu learnt, %llu evicted, %llu checked, %llu hits (%.1f%% of nodes), %llu letters removed, table %zu KB\n",
+			filler_stats.ng_learnt, filler_stats.ng_evicted, filler_stats.ng_checks, filler_stats.ng_hits,
+			100.0 * filler_stats.ng_hits / MX(filler_stats.nodes, 1), filler_stats.ng_prunes,
+			(NGMAX * sizeof(struct nogood) + NGHASH * sizeof(int) + (ne + 1) * sizeof(int)) / 1024);
+	if (filler_sac > 0)
+		fprintf(fp, "lookahead: %llu probes, %llu letters removed (%.1f per node), %llu nodes refuted, %.1f ms of %.1f ms searching\n",
+			filler_stats.sac_probes, filler_stats.sac_removed,
+			(double)filler_stats.sac_removed / MX(filler_stats.nodes, 1), filler_stats.sac_wipeouts,
+			filler_stats.sac_ns / 1e6, filler_stats.search_ns / 1e6);
+	if (filler_decomp)
+		fprintf(fp, "components: grid in pieces at %llu nodes, %.1f pieces on average\n",
+			filler_stats.splits, (double)filler_stats.comps / MX(filler_stats.splits, 1));
+	if (filler_alldiff)
+		fprintf(fp, "all-different: %llu nodes refuted, %llu candidates removed\n",
+			filler_stats.ad_fails, filler_stats.ad_prunes);
+	if (filler_nfills)
+		fprintf(fp, "fills: %llu, %llu more skipped as duplicates\n", filler_stats.fills, filler_stats.dupfills);
+	if (filler_restart > 0) {
+		fprintf(fp, "restarts: %llu\n", filler_stats.restarts);
+		fprintf(fp, "nodes per attempt:");
+		for (i = 0; i < nrsnodes; i++)
+			fprintf(fp, " %llu", rsnodes[i]);
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, "seed: %llu\n", filler_seed);
+}
+
+/* the counters as a JSON object, times in milliseconds */
+void filler_jstats(FILE*fp)
+{
+	const struct filler_stats *s = &filler_stats;
+
+	fprintf(fp, "{\"nodes\": %llu, \"backtracks\": %llu, \"max_depth\": %llu, ",
+		s->nodes, s->backtracks, s->maxdepth);
+	fprintf(fp, "\"settleents_passes\": %llu, \"settlewds_passes\": %llu, ",
+		s->ent_passes, s->wds_passes);
+	fprintf(fp, "\"candidates_removed\": %llu, \"listisect_removed\": %llu, ",
+		s->cands_removed, s->isect_removed);
+	fprintf(fp, "\"entq_pushes\": %llu, \"wdq_pushes\": %llu, \"backjumps\": %llu, ",
+		s->entq_pushes, s->wdq_pushes, s->backjumps);
+	fprintf(fp, "\"nogoods_learnt\": %llu, \"nogoods_evicted\": %llu, \"nogood_checks\": %llu, \"nogood_hits\": %llu, \"nogood_prunes\": %llu, ",
+		s->ng_learnt, s->ng_evicted, s->ng_checks, s->ng_hits, s->ng_prunes);
+	fprintf(fp, "\"restarts\": %llu, \"fills\": %llu, \"duplicate_fills\": %llu, ",
+		s->restarts, s->fills, s->dupfills);
+	fprintf(fp, "\"sac_probes\": %llu, \"sac_removed\": %llu, \"sac_wipeouts\": %llu, ",
+		s->sac_probes, s->sac_removed, s->sac_wipeouts);
+	fprintf(fp, "\"splits\": %llu, \"components\": %llu, \"alldiff_fails\": %llu, \"alldiff_prunes\": %llu, ",
+		s->splits, s->comps, s->ad_fails, s->ad_prunes);
+	fprintf(fp, "\"list_bytes\": %llu, \"build_ms\": %.3f, \"search_ms\": %.3f, ",
+		s->list_bytes, s->build_ns / 1e6, s->search_ns / 1e6);
+	fprintf(fp, "\"propagate_ms\": %.3f, \"score_ms\": %.3f, \"choose_ms\": %.3f, \"sac_ms\": %.3f}",
+		s->prop_ns / 1e6, s->score_ns / 1e6, s->crit_ns / 1e6, s->sac_ns / 1e6);
+}
+
 int filler_init(int mode)
 {
 	int i;
@@ -624,6 +2897,11 @@ int filler_init(int mode)
 	DEB1 pstate(0);
 
 	fillmode = mode;
+	rng_seed(&frng, filler_seed);
+	memset(&filler_stats, 0, sizeof(filler_stats));
+	nrsnodes = 0;
+	FREEX(fhash);
+	fhashcap = nfhash = 0;
 	if (allocstack())
 		return 1;
 	if (pregetinitflist())
@@ -644,3 +2922,152 @@ int filler_destroy()
 	state_finit();
 	return 0;
 }
+
+#ifdef KBENCH
+/*
+ * Kernel microbenchmarks, built into kbench only.  filler_kbcapture()
+ * leaves the state of a real search in place; filler_kbrun() then runs
+ * one kernel on it at a time between kb_start() and kb_stop(), putting
+ * the state back as search() would after each branching decision.
+ */
+
+/* search n nodes from the root, or just propagate if n is 0, and stay there; returns the depth or -1 */
+int filler_kbcapture(unsigned long long n)
+{
+	int f;
+
+	clueorderindex = 0;
+	if (buildlists() || filler_status == -3)
+		return -1;
+	mark_all();
+	if (n == 0) {
+		settlewds();
+		if (settle() < 0)
+			return -1;
+		mkscores();
+		return sdep;
+	}
+	filler_maxnodes = n;
+	f = search();
+	filler_maxnodes = 0;
+	return f == -6 || f == 2 ? sdep : -1;
+}
+
+/* fix entry e to its lowest feasible letter, as a decision would */
+static void kb_decide(int e)
+{
+	state_push();
+	entries[e].flbm &= -entries[e].flbm;
+	mark_entry(entries + e);
+}
+
+static void kb_undo(void)
+{
+	flush_queues();
+	state_pop();
+}
+
+/*
+ * Run kernel k reps times on the captured state.  *ops counts the calls
+ * timed and *items the candidates, entries or lights they went through.
+ * Returns 1 if there is nothing to run the kernel on.
+ */
+int filler_kbrun(int k, int reps, unsigned long long *ops, unsigned long long *items)
+{
+	struct word *w;
+	int i, j, r, e, n, len0, *open;
+	ABM m;
+
+	*ops = *items = 0;
+	open = malloc((ne + 1) * sizeof(int));
+	if (!open)
+		return 1;
+	for (i = 0, n = 0; i < ne; i++)
+		if (!onebit(entries[i].flbm) && entries[i].flbm)
+			open[n++] = i;
+	for (r = 0; r < reps; r++) {
+		switch (k) {
+		case KB_LISTISECT: // take one letter out of each position of each list
+			kb_start();
+			for (i = 0; i < nw; i++) {
+				w = words + i;
+				if (w->fe || !w->flistlen)
+					continue;
+				for (j = 0; j < w->nent; j++) {
+					m = w->e[j]->flbm;
+					listisect(w, w->flistlen, j, onebit(m) ? m : m & (m - 1));
+					(*ops)++;
+					*items += w->flistlen;
+				}
+			}
+			kb_stop();
+			break;
+		case KB_UFW: // filter the lists crossing a decision, as settleents() does
+			if (!n)
+				goto ex0;
+			e = open[r % n];
+			kb_decide(e);
+			kb_start();
+			for (j = ewoff[e]; j < ewoff[e + 1]; j++) {
+				i = ewlist[j];
+				w = words + i;
+				stack_save_wordlist(w, sdep, i);
+				len0 = w->flistlen;
+				update_feasible_words(w);
+				if (wsup[i] && w->flistlen != len0)
+					update_support(w, len0);
+				(*ops)++;
+				*items += len0;
+			}
+			kb_stop();
+			kb_undo();
+			break;
+		case KB_SETTLEWDS: // take the letters the lists no longer support out of the entries
+			if (!n)
+				goto ex0;
+			kb_decide(open[r % n]);
+			if (settleents() >= 0) {
+				for (j = 0; j < nwdq; j++)
+					*items += words[wdq[j]].flistlen;
+				kb_start();
+				settlewds();
+				kb_stop();
+				(*ops)++;
+			}
+			kb_undo();
+			break;
+		case KB_MKSCORES:
+			kb_start();
+			mkscores();
+			kb_stop();
+			(*ops)++;
+			for (i = 0; i < nw; i++)
+				if (!words[i].fe)
+					*items += words[i].flistlen;
+			break;
+		case KB_FINDCRITENT:
+			kb_start();
+			findcritent();
+			kb_stop();
+			(*ops)++;
+			*items += ne;
+			break;
+		case KB_FINDLIGHT: // look every light up again
+			kb_start();
+			for (i = 0; i < ltotal; i++)
+				kb_findlight(i);
+			kb_stop();
+			*ops += ltotal;
+			*items += ltotal;
+			break;
+		default:
+			goto ex0;
+		}
+	}
+	free(open);
+	return 0;
+ex0:
+	free(open);
+	return 1;
+}
+#endif
@@ -33,8 +33,71 @@ extern int filler_destroy();
 extern int filler_start(int mode);
 extern void filler_wait();
 extern void filler_stop();
-extern void getposs(struct entry*e,char*s,int r,int dash);
+extern void getposs(struct entry*e,char*s,int r,int dash,struct rng*g);
 extern int filler_status;
+extern int filler_jobs;
+extern int filler_steal;
+extern int filler_branch;
+extern int filler_nfills;
+extern int filler_sac;
+extern int filler_decomp;
+extern int filler_alldiff;
+extern int filler_nogoods;
+extern int filler_chrono;
+extern int filler_restart;
+extern double filler_rgrowth;
+extern double filler_timeout;
+extern double filler_progress;
+extern unsigned long long filler_seed;
+extern unsigned long long filler_maxnodes;
 extern int filler_search();
+extern void filler_pstats(FILE*fp);
+extern void filler_jstats(FILE*fp);
+
+// counters accumulated by the filler over a run
+struct filler_stats {
+  unsigned long long nodes;         // letters tried by search()
+  unsigned long long backtracks;    // failures search() has backed up from
+  unsigned long long maxdepth;      // deepest search level reached
+  unsigned long long ent_passes;    // settleents() calls
+  unsigned long long wds_passes;    // settlewds() calls
+  unsigned long long isect_removed; // candidates filtered out by listisect()
+  unsigned long long cands_removed; // candidates swapped out of live feasible lists
+  unsigned long long entq_pushes;   // entries queued for settleents()
+  unsigned long long wdq_pushes;    // words queued for settlewds()
+  unsigned long long backjumps;     // search levels skipped by conflict-directed backjumping
+  unsigned long long ng_learnt;     // nogoods added to the table
+  unsigned long long ng_evicted;    // nogoods dropped to make room
+  unsigned long long ng_checks;     // nogoods compared against the grid
+  unsigned long long ng_hits;       // nodes refuted by a nogood
+  unsigned long long ng_prunes;     // letters removed by nogoods one pair short of holding
+  unsigned long long restarts;      // attempts abandoned for a fresh start from the root
+  unsigned long long fills;         // distinct fills reported when enumerating
+  unsigned long long dupfills;      // fills skipped as using the same words as an earlier one
+  unsigned long long sac_probes;    // letters tried by the lookahead
+  unsigned long long sac_removed;   // letters the lookahead removed before branching
+  unsigned long long sac_wipeouts;  // nodes refuted by the lookahead removing every letter
+  unsigned long long sac_ns;        // time spent in the lookahead
+  unsigned long long splits;        // nodes where the unfixed entries fell into separate components
+  unsigned long long comps;         // components summed over those nodes
+  unsigned long long ad_fails;      // nodes refuted by the all-different propagator
+  unsigned long long ad_prunes;     // candidates it removed
+  unsigned long long search_ns;     // time spent searching
+  unsigned long long build_ns;      // time spent building the initial lists
+  unsigned long long prop_ns;       // time spent in search()'s propagation to a fixpoint
+  unsigned long long score_ns;      // time spent in mkscores()
+  unsigned long long crit_ns;       // time spent choosing the entry to branch on
+  unsigned long long list_bytes;    // size of the feasible lists and their indexes
+  };
+extern struct filler_stats filler_stats;
+
+#ifdef KBENCH
+// kernel microbenchmarks: see kbench.c
+enum { KB_LISTISECT, KB_UFW, KB_SETTLEWDS, KB_MKSCORES, KB_FINDCRITENT, KB_FINDLIGHT, KB_N };
+extern int filler_kbcapture(unsigned long long n);
+extern int filler_kbrun(int k, int reps, unsigned long long *ops, unsigned long long *items);
+extern void kb_start(void);
+extern void kb_stop(void);
+#endif
 
 #endif
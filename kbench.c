@@ -0,0 +1,197 @@
+/*
+Kernel microbenchmarks for the filler.
+
+This file is part of Qxw.
+
+Qxw is free software: you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License
+as published by the Free Software Foundation.
+
+Qxw is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Qxw.  If not, see <http://www.gnu.org/licenses/> or
+write to the Free Software Foundation, Inc., 51 Franklin Street,
+Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * kbench [-d <dictionary_file>]* [-c <nodes>[,<nodes>...]] [-n <reps>] < grid
+ *
+ * Builds the lists for the grid, as fill does, then for each capture
+ * point searches that many nodes (0: the state after the initial
+ * propagation) and times the filler's kernels on the state reached:
+ * listisect(), update_feasible_words(), settlewds(), mkscores(),
+ * findcritent() and findlight().  Each is reported in ns per call and
+ * candidates (for findcritent(), entries; for findlight(), lights)
+ * per second and, where perf_event_open() is allowed, in cycles,
+ * instructions and cache misses per call.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "common.h"
+#include "filler.h"
+#include "dicts.h"
+
+extern void initfill(void);
+extern int loadgrid(FILE *fp);
+
+static const char *kname[KB_N] = {
+	"listisect", "update_feasible_words", "settlewds", "mkscores", "findcritent", "findlight"
+};
+
+#define NPC 3
+static const unsigned long long pcconfig[NPC] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+};
+static int pcfd = -1;                     // group leader, or -1 if counters are not available
+static unsigned long long pc0[NPC], pcsum[NPC];
+static unsigned long long t0, tsum;
+
+static unsigned long long now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+/* open the hardware counters as one group counting this process in user mode */
+static void pc_open(void)
+{
+	struct perf_event_attr a;
+	int i, fd;
+
+	for (i = 0; i < NPC; i++) {
+		memset(&a, 0, sizeof(a));
+		a.size = sizeof(a);
+		a.type = PERF_TYPE_HARDWARE;
+		a.config = pcconfig[i];
+		a.disabled = i == 0;
+		a.exclude_kernel = 1;
+		a.exclude_hv = 1;
+		a.read_format = PERF_FORMAT_GROUP;
+		fd = syscall(__NR_perf_event_open, &a, 0, -1, pcfd, 0);
+		if (fd < 0) {
+			if (pcfd >= 0)
+				close(pcfd); // all or nothing, so that a group read has every counter
+			pcfd = -1;
+			return;
+		}
+		if (i == 0)
+			pcfd = fd;
+	}
+	ioctl(pcfd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static void pc_read(unsigned long long *v)
+{
+	unsigned long long b[NPC + 1];
+
+	if (read(pcfd, b, sizeof(b)) != sizeof(b))
+		memset(b, 0, sizeof(b));
+	memcpy(v, b + 1, NPC * sizeof(*v));
+}
+
+/* called by filler_kbrun() around each timed section */
+void kb_start(void)
+{
+	if (pcfd >= 0)
+		pc_read(pc0);
+	t0 = now_ns();
+}
+
+void kb_stop(void)
+{
+	unsigned long long v[NPC];
+	int i;
+
+	tsum += now_ns() - t0;
+	if (pcfd < 0)
+		return;
+	pc_read(v);
+	for (i = 0; i < NPC; i++)
+		pcsum[i] += v[i] - pc0[i];
+}
+
+static void kernel(int k, int reps)
+{
+	unsigned long long ops, items;
+
+	tsum = 0;
+	memset(pcsum, 0, sizeof(pcsum));
+	filler_kbrun(k, 1, &ops, &items); // warm the caches
+	tsum = 0;
+	memset(pcsum, 0, sizeof(pcsum));
+	if (filler_kbrun(k, reps, &ops, &items) || !ops) {
+		printf("%-22s %10s\n", kname[k], "-");
+		return;
+	}
+	printf("%-22s %10.1f %10.2f %10llu", kname[k], (double)tsum / ops, items * 1e3 / (tsum ? tsum : 1), ops);
+	if (pcfd >= 0)
+		printf(" %12.1f %12.1f %6.2f %10.2f", (double)pcsum[0] / ops, (double)pcsum[1] / ops,
+			pcsum[0] ? (double)pcsum[1] / pcsum[0] : 0.0, (double)pcsum[2] / ops);
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *cp = "0,100";
+	char *p;
+	unsigned long long n;
+	int c, d, k, nd = 0, reps = 100;
+
+	initfill();
+	while ((c = getopt(argc, argv, "c:d:n:")) != -1)
+		switch (c) {
+		case 'c': cp = optarg; break;
+		case 'd':
+			if (strlen(optarg) < SLEN && nd < MAXNDICTS)
+				strcpy(dfnames[nd++], optarg);
+			break;
+		case 'n': reps = atoi(optarg); break;
+		default:
+			fprintf(stderr, "Usage: %s [-d <dictionary_file>]* [-c <nodes>[,<nodes>...]] [-n <reps>] < grid\n", argv[0]);
+			return 1;
+		}
+	if (!nd)
+		strcpy(dfnames[0], "all_dict");
+	if (loaddicts(0) || loadgrid(stdin))
+		return 1;
+	pc_open();
+	if (pcfd < 0)
+		printf("hardware counters not available: timing only\n");
+
+	for (;;) {
+		n = strtoull(cp, &p, 10);
+		filler_init(1);
+		d = filler_kbcapture(n);
+		if (d < 0)
+			printf("\ncapture at %llu nodes failed\n", n);
+		else {
+			printf("\ncaptured after %llu nodes at depth %d\n", filler_stats.nodes, d);
+			printf("%-22s %10s %10s %10s", "kernel", "ns/call", "Mcand/s", "calls");
+			if (pcfd >= 0)
+				printf(" %12s %12s %6s %10s", "cycles/call", "insns/call", "IPC", "misses/call");
+			printf("\n");
+			for (k = 0; k < KB_N; k++)
+				kernel(k, reps);
+		}
+		filler_destroy();
+		if (*p != ',')
+			break;
+		cp = p + 1;
+	}
+	freedicts();
+	return 0;
+}
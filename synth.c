@@ -0,0 +1,366 @@
+/*
+Synthetic grids and dictionaries for scaling studies.
+
+This file is part of Qxw.
+
+Qxw is free software: you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License
+as published by the Free Software Foundation.
+
+Qxw is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Qxw.  If not, see <http://www.gnu.org/licenses/> or
+write to the Free Software Foundation, Inc., 51 Franklin Street,
+Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * synth grid [-s seed] [-w width] [-h height] [-b blocks] [-r 1|2|4] [-m 0-3]
+ *            [-u 0-3] [-l minlen] [-p prefill] [-f filled_grid]
+ * synth dict [-s seed] [-n words] [-l minlen] [-L maxlen] [-z exponent] [-a letters]
+ *
+ * grid writes a square grid in read_grid() format.  Blocks are added at
+ * random squares, together with the squares symmdo() pairs them with
+ * under the rotational (-r), mirror (-m) and up-and-down/left-and-right
+ * (-u) symmetry flags, until the given fraction of the grid is blocked;
+ * a block is refused if it would leave a light shorter than minlen, a
+ * square with no light, or the open squares disconnected.  -p then puts
+ * letters in that fraction of the open squares, drawn with English
+ * letter frequencies or, with -f, copied from a filled grid (such as
+ * fill's output), whose blocks are then used instead of random ones.
+ *
+ * dict writes distinct random words in load_dict() "word count" format,
+ * with lengths uniform over minlen..maxlen and letters drawn with English
+ * frequencies or, with -a, uniformly from the first that many letters.
+ * The word generated n-th gets count 10^9/n^exponent, so scores follow
+ * Zipf's law.
+ *
+ * Either output starts with a ';' comment line giving the full command,
+ * seed included, that recreates it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "common.h"
+#include "dicts.h"
+
+extern int width, height, symmr, symmm, symmd;
+extern void initfill(void);
+extern void symmdo(void f(int,int,int,int), int k, int x, int y, int d);
+
+// English letter frequencies, per thousand, A-Z
+static const int lfreq[26] = {
+	82, 15, 28, 43, 127, 22, 20, 61, 70, 2, 8, 40, 24, 67, 75, 19, 1, 60, 63, 91, 28, 10, 24, 2, 20, 1
+};
+
+static char g[MXSZ][MXSZ];      // the grid being built: '#' block, '.' open, or a letter
+static int chx[MXSZ*MXSZ], chy[MXSZ*MXSZ], nch; // squares changed by the last setsq() call
+
+static char randlet(int na)
+{
+	int i, t;
+
+	if (na)
+		return 'A' + rng_below(&crng, na);
+	for (i = 0, t = 0; i < 26; i++)
+		t += lfreq[i];
+	t = rng_below(&crng, t);
+	for (i = 0; t >= lfreq[i]; i++)
+		t -= lfreq[i];
+	return 'A' + i;
+}
+
+static void usage(const char *p)
+{
+	fprintf(stderr, "Usage: %s grid [-s seed] [-w width] [-h height] [-b blocks] [-r 1|2|4] [-m 0-3] [-u 0-3]\n"
+		"                 [-l minlen] [-p prefill] [-f filled_grid]\n"
+		"       %s dict [-s seed] [-n words] [-l minlen] [-L maxlen] [-z exponent] [-a letters]\n", p, p);
+	exit(1);
+}
+
+// GRIDS
+
+// symmdo() callback: make (x,y) a block
+static void setsq(int k, int x, int y, int d)
+{
+	if (g[x][y] == '#')
+		return;
+	g[x][y] = '#';
+	chx[nch] = x;
+	chy[nch++] = y;
+}
+
+// length of the run of open squares through (x,y) in direction (dx,dy)
+static int runlen(int x, int y, int dx, int dy)
+{
+	int i, j, l;
+
+	for (i = x, j = y, l = 0; i >= 0 && j >= 0 && g[i][j] != '#'; i -= dx, j -= dy)
+		l++;
+	for (i = x + dx, j = y + dy; i < width && j < height && g[i][j] != '#'; i += dx, j += dy)
+		l++;
+	return l;
+}
+
+// read the first grid in file fn, which may be fill's output; returns !=0 on error
+static int readfilled(const char *fn)
+{
+	char *line = NULL, *p;
+	size_t len = 0;
+	int i, w = 0, h = 0;
+	FILE *fp;
+
+	fp = fopen(fn, "r");
+	if (!fp)
+		return 1;
+	while (getline(&line, &len, fp) > 0) {
+		for (p = line; isspace((unsigned char)*p); p++)
+			;
+		for (i = 0; p[i] && (isalnum((unsigned char)p[i]) || strchr(".#*", p[i])); i++)
+			;
+		while (isspace((unsigned char)p[i]))
+			p[i++] = '\0';
+		if (!*p || p[i] || (w && (int)strlen(p) != w)) { // not a grid row
+			if (h)
+				break;
+			continue;
+		}
+		w = strlen(p);
+		if (w >= MXSZ || h >= MXSZ - 1) {
+			h = 0;
+			break;
+		}
+		for (i = 0; i < w; i++)
+			g[i][h] = toupper((unsigned char)p[i]);
+		h++;
+	}
+	free(line);
+	fclose(fp);
+	width = w;
+	height = h;
+	return !h;
+}
+
+// is the current pattern acceptable?
+static int gridok(int minlen)
+{
+	static int qx[MXSZ*MXSZ], qy[MXSZ*MXSZ];
+	static char seen[MXSZ][MXSZ];
+	int h, i, j, n, q, v;
+
+	for (i = 0, n = 0; i < width; i++)
+		for (j = 0; j < height; j++) {
+			if (g[i][j] == '#')
+				continue;
+			n++;
+			h = runlen(i, j, 1, 0);
+			v = runlen(i, j, 0, 1);
+			if ((h > 1 && h < minlen) || (v > 1 && v < minlen))
+				return 0;
+			if (h == 1 && v == 1 && width * height > 1)
+				return 0;
+		}
+	if (!n)
+		return 0;
+	memset(seen, 0, sizeof(seen));
+	for (i = 0; g[i % width][i / width] == '#'; i++)
+		;
+	qx[0] = i % width;
+	qy[0] = i / width;
+	seen[qx[0]][qy[0]] = 1;
+	for (q = 0, v = 1; q < v; q++) {
+		static const int dx[4] = {1, -1, 0, 0}, dy[4] = {0, 0, 1, -1};
+		for (h = 0; h < 4; h++) {
+			i = qx[q] + dx[h];
+			j = qy[q] + dy[h];
+			if (i < 0 || j < 0 || i >= width || j >= height || g[i][j] == '#' || seen[i][j])
+				continue;
+			seen[i][j] = 1;
+			qx[v] = i;
+			qy[v++] = j;
+		}
+	}
+	return v == n;
+}
+
+static int mkgrid(const char *prog, int argc, char *argv[])
+{
+	static int ox[MXSZ*MXSZ], oy[MXSZ*MXSZ];
+	const char *bs = "0.16", *ps = "0", *fn = NULL;
+	unsigned long long seed = time(0) ^ ((unsigned long long)getpid() << 32);
+	int c, i, j, k, nb, no, tries, minlen = 3;
+
+	width = height = 15;
+	symmr = 2;
+	symmm = symmd = 0;
+	while ((c = getopt(argc, argv, "s:w:h:b:r:m:u:l:p:f:")) != -1)
+		switch (c) {
+		case 's': seed = strtoull(optarg, NULL, 10); break;
+		case 'w': width = atoi(optarg); break;
+		case 'h': height = atoi(optarg); break;
+		case 'b': bs = optarg; break;
+		case 'r': symmr = atoi(optarg); break;
+		case 'm': symmm = atoi(optarg); break;
+		case 'u': symmd = atoi(optarg); break;
+		case 'l': minlen = atoi(optarg); break;
+		case 'p': ps = optarg; break;
+		case 'f': fn = optarg; break;
+		default: usage(prog);
+		}
+	rng_seed(&crng, seed);
+
+	if (fn) {
+		if (readfilled(fn)) {
+			fprintf(stderr, "cannot read grid %s\n", fn);
+			return 1;
+		}
+		printf("; %s grid -s %llu -p %s -f %s\n", prog, seed, ps, fn);
+	} else {
+		if (width < 1 || height < 1 || width >= MXSZ || height >= MXSZ) {
+			fprintf(stderr, "grid size must be between 1 and %d\n", MXSZ - 1);
+			return 1;
+		}
+		if ((symmr != 1 && symmr != 2 && symmr != 4) || (symmr == 4 && width != height) ||
+		    symmm < 0 || symmm > 3 || symmd < 0 || symmd > 3) {
+			fprintf(stderr, "bad symmetry: -r must be 1, 2 or 4 (4 only for square grids), -m and -u 0 to 3\n");
+			return 1;
+		}
+		memset(g, '.', sizeof(g));
+		nb = atof(bs) * width * height + 0.5;
+		for (k = 0, tries = 0; k < nb && tries < 50 * width * height; tries++) {
+			i = rng_below(&crng, width);
+			j = rng_below(&crng, height);
+			if (g[i][j] == '#')
+				continue;
+			nch = 0;
+			symmdo(setsq, 0, i, j, 0);
+			if (gridok(minlen)) {
+				k += nch;
+				continue;
+			}
+			while (nch--) // undo
+				g[chx[nch]][chy[nch]] = '.';
+		}
+		if (k < nb)
+			fprintf(stderr, "placed only %d of %d blocks\n", k, nb);
+		printf("; %s grid -s %llu -w %d -h %d -b %s -r %d -m %d -u %d -l %d -p %s\n",
+			prog, seed, width, height, bs, symmr, symmm, symmd, minlen, ps);
+	}
+
+	// choose the prefilled squares with a partial shuffle of the open ones
+	for (i = 0, no = 0; i < width; i++)
+		for (j = 0; j < height; j++)
+			if (g[i][j] != '#' && g[i][j] != '*')
+				ox[no] = i, oy[no++] = j;
+	k = atof(ps) * no + 0.5;
+	for (i = 0; i < no; i++) {
+		j = i + rng_below(&crng, no - i);
+		c = ox[i], ox[i] = ox[j], ox[j] = c;
+		c = oy[i], oy[i] = oy[j], oy[j] = c;
+		if (i >= k)
+			g[ox[i]][oy[i]] = '.';
+		else if (g[ox[i]][oy[i]] == '.')
+			g[ox[i]][oy[i]] = randlet(0);
+	}
+
+	for (j = 0; j < height; j++) {
+		for (i = 0; i < width; i++)
+			putchar(g[i][j]);
+		putchar('\n');
+	}
+	return 0;
+}
+
+// DICTIONARIES
+
+static unsigned int hashw(const char *s)
+{
+	unsigned int h = 2166136261U;
+
+	while (*s)
+		h = (h ^ (unsigned char)*s++) * 16777619U;
+	return h;
+}
+
+static int mkdict(const char *prog, int argc, char *argv[])
+{
+	const char *zs = "1";
+	unsigned long long seed = time(0) ^ ((unsigned long long)getpid() << 32);
+	unsigned long long ct;
+	char **tab, w[MXLE + 1];
+	int c, i, l, n = 10000, na = 0, nw, ntab, tries, minlen = 3, maxlen = 15;
+	unsigned int h;
+	double z;
+
+	while ((c = getopt(argc, argv, "s:n:l:L:z:a:")) != -1)
+		switch (c) {
+		case 's': seed = strtoull(optarg, NULL, 10); break;
+		case 'n': n = atoi(optarg); break;
+		case 'l': minlen = atoi(optarg); break;
+		case 'L': maxlen = atoi(optarg); break;
+		case 'z': zs = optarg; break;
+		case 'a': na = atoi(optarg); break;
+		default: usage(prog);
+		}
+	if (n < 1 || minlen < 1 || maxlen < minlen || maxlen > MXLE || na < 0 || na > 26) {
+		fprintf(stderr, "need at least one word, 1<=minlen<=maxlen<=%d and 0<=letters<=26\n", MXLE);
+		return 1;
+	}
+	rng_seed(&crng, seed);
+	z = atof(zs);
+
+	for (ntab = 1024; ntab < 2 * n; ntab *= 2)
+		;
+	tab = calloc(ntab, sizeof(*tab));
+	if (!tab) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	printf("; %s dict -s %llu -n %d -l %d -L %d -z %s -a %d\n", prog, seed, n, minlen, maxlen, zs, na);
+	for (nw = 0, tries = 0; nw < n && tries < 100; ) {
+		l = minlen + rng_below(&crng, maxlen - minlen + 1);
+		for (i = 0; i < l; i++)
+			w[i] = randlet(na);
+		w[l] = '\0';
+		for (h = hashw(w) & (ntab - 1); tab[h]; h = (h + 1) & (ntab - 1))
+			if (!strcmp(tab[h], w))
+				break;
+		if (tab[h]) { // seen already: give up if the space of words looks exhausted
+			tries++;
+			continue;
+		}
+		tries = 0;
+		tab[h] = strdup(w);
+		nw++;
+		ct = 1e9 / pow(nw, z) + 0.5;
+		printf("%s %llu\n", w, ct ? ct : 1);
+	}
+	if (nw < n)
+		fprintf(stderr, "generated only %d of %d words\n", nw, n);
+	for (i = 0; i < ntab; i++)
+		free(tab[i]);
+	free(tab);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+		usage(argv[0]);
+	initfill();
+	if (!strcmp(argv[1], "grid"))
+		return mkgrid(argv[0], argc - 1, argv + 1);
+	if (!strcmp(argv[1], "dict"))
+		return mkdict(argv[0], argc - 1, argv + 1);
+	usage(argv[0]);
+	return 1;
+}